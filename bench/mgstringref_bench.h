@@ -0,0 +1,102 @@
+#ifndef MGSTRINGREF_BENCH_H
+#define MGSTRINGREF_BENCH_H
+
+#include "mgstringref.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace bench {
+    // Minimum duration of a measured run, in nanoseconds. Set by --quick for smoke runs.
+    inline double& min_run_ns()
+    {
+        static double ns = 1e8;
+        return ns;
+    }
+
+    // Keeps the value alive, so that the compiler does not remove its computation.
+    template<typename T>
+    inline void keep(const T& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    // Nanoseconds per operation of fn(n), which performs n operations. n is doubled until a run takes at least
+    // min_run_ns(), then the best of three runs is taken, so that warm-up and scheduling noise are excluded.
+    template<typename _Fn>
+    double ns_per_op(_Fn fn)
+    {
+        typedef std::chrono::steady_clock clock;
+        std::size_t n = 1;
+        double best = 0;
+        for (;;) {
+            clock::time_point start = clock::now();
+            fn(n);
+            best = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start)
+                                           .count());
+            if ((best >= min_run_ns()) || (n >= (static_cast<std::size_t>(1) << 40))) {
+                break;
+            }
+            n *= 2;
+        }
+        for (int run = 0; run < 2; ++run) {
+            clock::time_point start = clock::now();
+            fn(n);
+            best = std::min(best, static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count()));
+        }
+        return best / static_cast<double>(n);
+    }
+
+    // Heap bytes in use by the bench executable, counted by its operator new.
+    inline std::atomic<std::size_t>& heap_in_use()
+    {
+        static std::atomic<std::size_t> bytes(0);
+        return bytes;
+    }
+
+    // Prints one line of the report. Variants of the same case are compared with the first one, the baseline.
+    inline void report(const char* name, const char* variant, double ns, double baseline_ns, const char* unit = "ns/op")
+    {
+        printf("  %-36s %-28s %12.2f %-5s %8.2fx\n", name, variant, ns, unit, baseline_ns / ns);
+    }
+
+    typedef void (*bench_function)();
+
+    struct entry {
+        const char* name_;
+        bench_function fn_;
+    };
+
+    inline std::vector<entry>& registry()
+    {
+        static std::vector<entry> entries;
+        return entries;
+    }
+
+    struct registrar {
+        registrar(const char* name, bench_function fn)
+        {
+            registry().push_back(entry{name, fn});
+        }
+    };
+}
+
+// Defines a benchmark, which is run by the bench executable, unless excluded by the filter on the command line.
+#define MGSTRINGREF_BENCH(name) \
+    static void name##_bench(); \
+    static bench::registrar name##_registrar(#name, &name##_bench); \
+    static void name##_bench()
+
+#endif // MGSTRINGREF_BENCH_H
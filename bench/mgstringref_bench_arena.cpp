@@ -0,0 +1,50 @@
+#include "mgstringref_bench.h"
+#include "mgstringref_arena.h"
+
+namespace {
+    // Number of stringrefs detached while processing one request.
+    const std::size_t request_size = 256;
+
+    // Each request detaches request_size strings, which are all released at the end of the request.
+    template<typename _Stringref, typename _MakeAllocator, typename _EndRequest>
+    double detach_ns(const std::vector<std::string>& texts, _MakeAllocator make_allocator, _EndRequest end_request)
+    {
+        return bench::ns_per_op([&](std::size_t n) {
+            std::vector<_Stringref> detached;
+            detached.reserve(request_size);
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::string& text = texts[i % texts.size()];
+                detached.emplace_back(text.data(), text.size(), _Stringref::detached, make_allocator());
+                if (request_size == detached.size()) {
+                    bench::keep(detached.back());
+                    detached.clear();
+                    end_request();
+                }
+            }
+            detached.clear();
+            end_request();
+        });
+    }
+}
+
+MGSTRINGREF_BENCH(arena_detach)
+{
+    std::vector<std::string> texts;
+    for (std::size_t length = 16; length <= 64; length += 8) {
+        texts.push_back(std::string(length, static_cast<char>('a' + texts.size())));
+    }
+
+    typedef mg::basic_stringref<char, std::char_traits<char>, std::allocator<char>, mg::single_thread_refcount>
+        single_thread_stringref;
+    const double baseline = detach_ns<mg::stringref>(texts, []() { return std::allocator<char>(); }, []() {});
+    bench::report("detach, 256 per request", "std::allocator", baseline, baseline);
+    bench::report("detach, 256 per request", "std::allocator, no atomics",
+                  detach_ns<single_thread_stringref>(texts, []() { return std::allocator<char>(); }, []() {}),
+                  baseline);
+
+    mg::stringref_arena arena;
+    bench::report("detach, 256 per request", "stringref_arena",
+                  detach_ns<mg::arena_stringref>(texts, [&arena]() { return mg::arena_allocator<char>(arena); },
+                                                 [&arena]() { arena.reset(); }),
+                  baseline);
+}
@@ -0,0 +1,74 @@
+#include "mgstringref_bench.h"
+
+#include <clocale>
+#include <cwctype>
+#include <string>
+
+namespace {
+    // Case-insensitive compare with std::towupper per character, as ci_char_traits<wchar_t> did before.
+    int towupper_compare(const wchar_t* s1, const wchar_t* s2, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::wint_t c1 = std::towupper(static_cast<std::wint_t>(s1[i]));
+            std::wint_t c2 = std::towupper(static_cast<std::wint_t>(s2[i]));
+            if (c1 != c2) {
+                return (c1 < c2) ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // Nanoseconds per compared character.
+    template<typename _CharT, typename _Compare>
+    double compare_ns(const std::basic_string<_CharT>& s1, const std::basic_string<_CharT>& s2, _Compare compare)
+    {
+        return bench::ns_per_op([&s1, &s2, &compare](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                bench::keep(compare(s1.data(), s2.data(), s1.size()));
+            }
+        }) / static_cast<double>(s1.size());
+    }
+
+    template<typename _String>
+    _String repeat(const _String& text, std::size_t length)
+    {
+        _String result;
+        while (result.size() < length) {
+            result += text;
+        }
+        result.resize(length);
+        return result;
+    }
+}
+
+// Strings are equal, except for the case of letters. Cyrillic text has no ASCII letters to take a shortcut.
+MGSTRINGREF_BENCH(casefold_compare)
+{
+    const std::size_t length = 1024;
+    const std::wstring latin = repeat<std::wstring>(L"Content-Type: text/html; ", length);
+    const std::wstring latin_upper = repeat<std::wstring>(L"CONTENT-TYPE: TEXT/HTML; ", length);
+    const std::wstring cyrillic = repeat<std::wstring>(L"текст ", length);
+    const std::wstring cyrillic_upper = repeat<std::wstring>(L"ТЕКСТ ", length);
+    const std::u16string ucyrillic = repeat<std::u16string>(u"текст ", length);
+    const std::u16string ucyrillic_upper = repeat<std::u16string>(u"ТЕКСТ ", length);
+
+    // std::towupper converts Cyrillic letters only in a Unicode locale.
+    const bool unicode_locale = (nullptr != std::setlocale(LC_CTYPE, "C.UTF-8"));
+    if (!unicode_locale) {
+        printf("  C.UTF-8 locale is not available, std::towupper does not convert Cyrillic letters\n");
+    }
+
+    double baseline = compare_ns(latin, latin_upper, &towupper_compare);
+    bench::report("wchar_t Latin, 1024 chars", "std::towupper", baseline, baseline);
+    bench::report("wchar_t Latin, 1024 chars", "ci_char_traits",
+                  compare_ns(latin, latin_upper, &mg::ci_char_traits<wchar_t>::compare), baseline);
+
+    baseline = compare_ns(cyrillic, cyrillic_upper, &towupper_compare);
+    bench::report("wchar_t Cyrillic, 1024 chars", "std::towupper", baseline, baseline);
+    bench::report("wchar_t Cyrillic, 1024 chars", "ci_char_traits",
+                  compare_ns(cyrillic, cyrillic_upper, &mg::ci_char_traits<wchar_t>::compare), baseline);
+    bench::report("char16_t Cyrillic, 1024 chars", "ci_char_traits",
+                  compare_ns(ucyrillic, ucyrillic_upper, &mg::ci_char_traits<char16_t>::compare), baseline);
+
+    std::setlocale(LC_CTYPE, "C");
+}
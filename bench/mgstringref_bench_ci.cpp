@@ -0,0 +1,62 @@
+#include "mgstringref_bench.h"
+
+#include <cctype>
+#include <string>
+
+namespace {
+    // Case-insensitive compare with std::toupper per character, as ci_char_traits<char> did before.
+    int toupper_compare(const char* s1, const char* s2, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            int c1 = std::toupper(static_cast<unsigned char>(s1[i]));
+            int c2 = std::toupper(static_cast<unsigned char>(s2[i]));
+            if (c1 != c2) {
+                return (c1 < c2) ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // Nanoseconds per compared character.
+    template<typename _Compare>
+    double compare_ns(const std::string& s1, const std::string& s2, _Compare compare)
+    {
+        return bench::ns_per_op([&s1, &s2, &compare](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                bench::keep(compare(s1.data(), s2.data(), s1.size()));
+            }
+        }) / static_cast<double>(s1.size());
+    }
+}
+
+// Strings are equal, except for the case of letters, so the whole length is compared.
+MGSTRINGREF_BENCH(ci_compare)
+{
+    for (std::size_t length = 16; length <= 4096; length *= 16) {
+        std::string lower;
+        while (lower.size() < length) {
+            lower += "content-type: text/html; charset=utf-8, ";
+        }
+        lower.resize(length);
+        std::string upper(lower);
+        for (char& c : upper) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        std::string non_ascii(lower);
+        non_ascii[length / 2] = static_cast<char>(0xE9);
+        std::string non_ascii_upper(upper);
+        non_ascii_upper[length / 2] = static_cast<char>(0xE9);
+
+        char name[64];
+        snprintf(name, sizeof(name), "ASCII, %zu chars", length);
+        double baseline = compare_ns(lower, upper, &toupper_compare);
+        bench::report(name, "std::toupper", baseline, baseline);
+        bench::report(name, "ci_char_traits", compare_ns(lower, upper, &mg::ci_char_traits<char>::compare), baseline);
+
+        snprintf(name, sizeof(name), "non-ASCII in the middle, %zu chars", length);
+        baseline = compare_ns(non_ascii, non_ascii_upper, &toupper_compare);
+        bench::report(name, "std::toupper", baseline, baseline);
+        bench::report(name, "ci_char_traits",
+                      compare_ns(non_ascii, non_ascii_upper, &mg::ci_char_traits<char>::compare), baseline);
+    }
+}
@@ -0,0 +1,66 @@
+#include "mgstringref_bench.h"
+
+#include <cctype>
+#include <cwchar>
+#include <cwctype>
+#include <string>
+
+namespace {
+    // Case-insensitive find with a conversion per character, as ci_char_traits did before.
+    const char* toupper_find(const char* s, std::size_t n, char c)
+    {
+        const int u = std::toupper(static_cast<unsigned char>(c));
+        for (std::size_t i = 0; i < n; ++i) {
+            if (std::toupper(static_cast<unsigned char>(s[i])) == u) {
+                return s + i;
+            }
+        }
+        return nullptr;
+    }
+
+    const wchar_t* towupper_find(const wchar_t* s, std::size_t n, wchar_t c)
+    {
+        const std::wint_t u = std::towupper(static_cast<std::wint_t>(c));
+        for (std::size_t i = 0; i < n; ++i) {
+            if (std::towupper(static_cast<std::wint_t>(s[i])) == u) {
+                return s + i;
+            }
+        }
+        return nullptr;
+    }
+
+    // Nanoseconds per scanned character. The target is the last character of the string.
+    template<typename _CharT, typename _Find>
+    double find_ns(const std::basic_string<_CharT>& str, _CharT c, _Find find)
+    {
+        return bench::ns_per_op([&str, c, &find](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                bench::keep(find(str.data(), str.size(), c));
+            }
+        }) / static_cast<double>(str.size());
+    }
+}
+
+// memchr and wmemchr, which are case-sensitive, show the speed limit.
+MGSTRINGREF_BENCH(ci_find)
+{
+    for (std::size_t length = 64; length <= 64 * 1024; length *= 32) {
+        std::string str(length - 1, 'a');
+        str += 'X';
+        std::wstring wstr(length - 1, L'a');
+        wstr += L'X';
+        char name[64];
+
+        snprintf(name, sizeof(name), "find char, %zu chars", length);
+        double baseline = find_ns(str, 'x', &toupper_find);
+        bench::report(name, "std::toupper", baseline, baseline);
+        bench::report(name, "ci_char_traits", find_ns(str, 'x', &mg::ci_char_traits<char>::find), baseline);
+        bench::report(name, "memchr", find_ns(str, 'X', &std::char_traits<char>::find), baseline);
+
+        snprintf(name, sizeof(name), "find wchar_t, %zu chars", length);
+        baseline = find_ns(wstr, L'x', &towupper_find);
+        bench::report(name, "std::towupper", baseline, baseline);
+        bench::report(name, "ci_char_traits", find_ns(wstr, L'x', &mg::ci_char_traits<wchar_t>::find), baseline);
+        bench::report(name, "wmemchr", find_ns(wstr, L'X', &std::char_traits<wchar_t>::find), baseline);
+    }
+}
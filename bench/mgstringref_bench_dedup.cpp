@@ -0,0 +1,72 @@
+#include "mgstringref_bench.h"
+
+#include <random>
+#include <string>
+
+namespace {
+    // Request fields: many repeats of a small set of values, too long to be stored inline.
+    std::vector<std::string> make_fields(std::size_t count, std::size_t distinct)
+    {
+        std::mt19937 rng(7);
+        std::vector<std::string> values;
+        for (std::size_t i = 0; i < distinct; ++i) {
+            values.push_back("application/vnd.example." + std::to_string(rng()) + "+json; charset=utf-8");
+        }
+        std::vector<std::string> fields;
+        for (std::size_t i = 0; i < count; ++i) {
+            fields.push_back(values[rng() % distinct]);
+        }
+        return fields;
+    }
+
+    void detach_all(const std::vector<std::string>& fields, std::vector<mg::stringref>& detached)
+    {
+        for (const std::string& field : fields) {
+            detached.emplace_back(field.data(), field.size(), mg::stringref::detached);
+        }
+    }
+
+    // Nanoseconds per detached copy, including its release.
+    double detach_ns(const std::vector<std::string>& fields)
+    {
+        std::vector<mg::stringref> detached;
+        detached.reserve(fields.size());
+        return bench::ns_per_op([&fields, &detached](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                detach_all(fields, detached);
+                bench::keep(detached.back());
+                detached.clear();
+            }
+        }) / static_cast<double>(fields.size());
+    }
+
+    // Heap bytes per detached copy, the array of stringrefs included.
+    double detach_bytes(const std::vector<std::string>& fields)
+    {
+        const std::size_t before = bench::heap_in_use().load();
+        std::vector<mg::stringref> detached;
+        detached.reserve(fields.size());
+        detach_all(fields, detached);
+        return static_cast<double>(bench::heap_in_use().load() - before) / static_cast<double>(fields.size());
+    }
+}
+
+// Deduplication is process-wide for mg::stringref, it is disabled again before the other benchmarks.
+MGSTRINGREF_BENCH(dedup)
+{
+    const std::vector<std::string> fields = make_fields(64 * 1024, 256);
+
+    const char* memory = "bytes per copy, 64K of 256 values";
+    const double baseline_bytes = detach_bytes(fields);
+    bench::report(memory, "separate blocks", baseline_bytes, baseline_bytes, "B");
+    mg::stringref::set_dedup(true);
+    bench::report(memory, "set_dedup(true)", detach_bytes(fields), baseline_bytes, "B");
+    mg::stringref::set_dedup(false);
+
+    const char* detach = "detach and release, 64K of 256";
+    const double baseline = detach_ns(fields);
+    bench::report(detach, "separate blocks", baseline, baseline);
+    mg::stringref::set_dedup(true);
+    bench::report(detach, "set_dedup(true)", detach_ns(fields), baseline);
+    mg::stringref::set_dedup(false);
+}
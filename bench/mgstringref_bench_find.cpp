@@ -0,0 +1,81 @@
+#include "mgstringref_bench.h"
+
+#include <random>
+#include <string>
+
+namespace {
+    // Random lowercase letters, so that searches for other characters scan the whole string.
+    template<typename _String>
+    _String random_letters(std::size_t length)
+    {
+        std::mt19937 rng(42);
+        _String str(length, 'a');
+        for (std::size_t i = 0; i < length; ++i) {
+            str[i] = static_cast<typename _String::value_type>('a' + rng() % 26);
+        }
+        return str;
+    }
+
+    // Nanoseconds per scanned character.
+    template<typename _Search>
+    double scan_ns(std::size_t length, _Search search)
+    {
+        return bench::ns_per_op([&search](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                bench::keep(search());
+            }
+        }) / static_cast<double>(length);
+    }
+}
+
+// There is no std::string_view in C++11, std::basic_string::find is the standard baseline.
+MGSTRINGREF_BENCH(find_char)
+{
+    for (std::size_t length = 64; length <= 64 * 1024; length *= 32) {
+        const std::string str = random_letters<std::string>(length) + "X";
+        const std::u16string ustr = random_letters<std::u16string>(length) + u"X";
+        const mg::stringref s(str);
+        const mg::ustringref us(ustr);
+        char name[64];
+
+        snprintf(name, sizeof(name), "find char, %zu chars", length);
+        double baseline = scan_ns(length, [&str]() { return str.find('X'); });
+        bench::report(name, "std::string", baseline, baseline);
+        bench::report(name, "stringref", scan_ns(length, [&s]() { return s.find('X'); }), baseline);
+
+        snprintf(name, sizeof(name), "rfind char, %zu chars", length);
+        baseline = scan_ns(length, [&str]() { return str.rfind('Y'); });
+        bench::report(name, "std::string", baseline, baseline);
+        bench::report(name, "stringref", scan_ns(length, [&s]() { return s.rfind('Y'); }), baseline);
+
+        snprintf(name, sizeof(name), "find char16_t, %zu chars", length);
+        baseline = scan_ns(length, [&ustr]() { return ustr.find(u'X'); });
+        bench::report(name, "std::u16string", baseline, baseline);
+        bench::report(name, "ustringref", scan_ns(length, [&us]() { return us.find(u'X'); }), baseline);
+
+        snprintf(name, sizeof(name), "find_first_of 4 chars, %zu chars", length);
+        baseline = scan_ns(length, [&str]() { return str.find_first_of("XYZ."); });
+        bench::report(name, "std::string", baseline, baseline);
+        bench::report(name, "stringref", scan_ns(length, [&s]() { return s.find_first_of("XYZ."); }), baseline);
+
+        snprintf(name, sizeof(name), "find_first_not_of, %zu chars", length);
+        const std::string letters("abcdefghijklmnopqrstuvwxyz");
+        baseline = scan_ns(length, [&str, &letters]() { return str.find_first_not_of(letters); });
+        bench::report(name, "std::string", baseline, baseline);
+        bench::report(name, "stringref", scan_ns(length, [&s, &letters]() { return s.find_first_not_of(letters); }),
+                      baseline);
+
+        // Validation of a hex string, the set fits in vector registers.
+        snprintf(name, sizeof(name), "find_first_not_of hex, %zu chars", length);
+        const std::string digits("0123456789abcdef");
+        std::string hex(str);
+        for (char& c : hex) {
+            c = digits[static_cast<std::size_t>(c) % digits.size()];
+        }
+        const mg::stringref h(hex);
+        baseline = scan_ns(length, [&hex, &digits]() { return hex.find_first_not_of(digits); });
+        bench::report(name, "std::string", baseline, baseline);
+        bench::report(name, "stringref", scan_ns(length, [&h, &digits]() { return h.find_first_not_of(digits); }),
+                      baseline);
+    }
+}
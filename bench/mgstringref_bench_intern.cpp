@@ -0,0 +1,110 @@
+#include "mgstringref_bench.h"
+#include "mgstringref_intern.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+
+namespace {
+    // Tokens of a parsed document: many occurrences of a small vocabulary, too long to be stored inline.
+    std::vector<std::string> make_tokens(std::size_t count, std::size_t distinct)
+    {
+        std::mt19937 rng(42);
+        std::vector<std::string> vocabulary;
+        for (std::size_t i = 0; i < distinct; ++i) {
+            std::string word(24 + rng() % 40, 'a');
+            for (char& c : word) {
+                c = static_cast<char>('a' + rng() % 26);
+            }
+            vocabulary.push_back(word);
+        }
+        std::vector<std::string> tokens;
+        for (std::size_t i = 0; i < count; ++i) {
+            tokens.push_back(vocabulary[rng() % distinct]);
+        }
+        return tokens;
+    }
+
+    // Heap bytes per token held by the container, which is filled by fill(container). The array of the container
+    // is included.
+    template<typename _Container, typename _Fill>
+    double bytes_per_token(std::size_t tokens, _Fill fill)
+    {
+        const std::size_t before = bench::heap_in_use().load();
+        _Container container;
+        container.reserve(tokens);
+        fill(container);
+        return static_cast<double>(bench::heap_in_use().load() - before) / static_cast<double>(tokens);
+    }
+
+    // Nanoseconds per lookup of the keys in the set.
+    template<typename _Set, typename _Key>
+    double find_ns(const _Set& set, const std::vector<_Key>& keys)
+    {
+        return bench::ns_per_op([&set, &keys](std::size_t n) {
+            std::size_t found = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                found += set.count(keys[i % keys.size()]);
+            }
+            bench::keep(found);
+        });
+    }
+}
+
+// Memory is the heap in use per token, the pool included; it is reported in bytes instead of nanoseconds.
+MGSTRINGREF_BENCH(intern)
+{
+    const std::size_t count = 64 * 1024;
+    const std::size_t distinct = 1024;
+    const std::vector<std::string> tokens = make_tokens(count, distinct);
+
+    const char* memory = "bytes per token, 64K of 1K words";
+    const double baseline_bytes = bytes_per_token<std::vector<std::string> >(count, [&tokens](
+        std::vector<std::string>& v) {
+        for (const std::string& token : tokens) {
+            v.push_back(token);
+        }
+    });
+    bench::report(memory, "std::string", baseline_bytes, baseline_bytes, "B");
+    bench::report(memory, "detached stringref", bytes_per_token<std::vector<mg::stringref> >(count, [&tokens](
+        std::vector<mg::stringref>& v) {
+        for (const std::string& token : tokens) {
+            v.push_back(mg::stringref(token, mg::stringref::detached));
+        }
+    }), baseline_bytes, "B");
+    std::unique_ptr<mg::stringref_intern_pool> counted_pool;
+    bench::report(memory, "interned_stringref", bytes_per_token<std::vector<mg::interned_stringref> >(
+        count, [&tokens, &counted_pool](std::vector<mg::interned_stringref>& v) {
+        counted_pool.reset(new mg::stringref_intern_pool());
+        for (const std::string& token : tokens) {
+            v.push_back(counted_pool->intern(token));
+        }
+    }), baseline_bytes, "B");
+
+    // Lookup of the vocabulary in a set of all words.
+    mg::stringref_intern_pool pool;
+    std::vector<std::string> strings;
+    std::vector<mg::stringref> stringrefs;
+    std::vector<mg::interned_stringref> handles;
+    for (std::size_t i = 0; i < distinct; ++i) {
+        strings.push_back(tokens[i]);
+        stringrefs.push_back(mg::stringref(tokens[i], mg::stringref::detached));
+        handles.push_back(pool.intern(tokens[i]));
+    }
+    const std::unordered_set<std::string> string_set(strings.begin(), strings.end());
+    const std::unordered_set<mg::stringref> stringref_set(stringrefs.begin(), stringrefs.end());
+    const std::unordered_set<mg::interned_stringref> handle_set(handles.begin(), handles.end());
+
+    const char* lookup = "find in unordered_set";
+    const double baseline = find_ns(string_set, strings);
+    bench::report(lookup, "std::string", baseline, baseline);
+    bench::report(lookup, "detached stringref", find_ns(stringref_set, stringrefs), baseline);
+    bench::report(lookup, "interned_stringref", find_ns(handle_set, handles), baseline);
+    bench::report("intern an existing word", "intern_pool::intern()", bench::ns_per_op([&pool, &strings](
+        std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            bench::keep(pool.intern(strings[i % strings.size()]));
+        }
+    }), baseline);
+}
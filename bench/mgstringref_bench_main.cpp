@@ -0,0 +1,51 @@
+#include "mgstringref_bench.h"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Each heap block keeps its size in a header, so that bench::heap_in_use() is known after frees as well.
+namespace {
+    const std::size_t heap_header_len = 16;
+}
+
+void* operator new(std::size_t size)
+{
+    char* p = static_cast<char*>(std::malloc(size + heap_header_len));
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<std::size_t*>(p) = size;
+    bench::heap_in_use().fetch_add(size, std::memory_order_relaxed);
+    return p + heap_header_len;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (nullptr != ptr) {
+        char* p = static_cast<char*>(ptr) - heap_header_len;
+        bench::heap_in_use().fetch_sub(*reinterpret_cast<std::size_t*>(p), std::memory_order_relaxed);
+        std::free(p);
+    }
+}
+
+// Usage: mgstringref_bench [--quick] [filter]. Only benchmarks with the filter in their name are run.
+int main(int argc, char** argv)
+{
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        if (0 == std::strcmp(argv[i], "--quick")) {
+            bench::min_run_ns() = 1e6;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    for (const bench::entry& e : bench::registry()) {
+        if (std::string(e.name_).find(filter) != std::string::npos) {
+            printf("%s\n", e.name_);
+            e.fn_();
+        }
+    }
+    return 0;
+}
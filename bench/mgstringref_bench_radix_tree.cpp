@@ -0,0 +1,102 @@
+#include "mgstringref_bench.h"
+#include "mgstringref_radix_tree.h"
+
+#include <map>
+#include <random>
+#include <string>
+
+namespace {
+    typedef std::map<std::string, std::size_t> string_map;
+    typedef std::map<mg::stringref, std::size_t> stringref_map;
+    typedef mg::stringref_radix_tree<std::size_t> radix_tree;
+
+    // Keys of a REST API: long common prefixes and wide fan-out after them.
+    std::vector<std::string> make_keys(std::size_t count)
+    {
+        std::mt19937 rng(42);
+        std::vector<std::string> keys;
+        for (std::size_t i = 0; i < count; ++i) {
+            keys.push_back("/api/v1/tenants/" + std::to_string(rng() % 1000) + "/objects/" + std::to_string(rng()));
+        }
+        return keys;
+    }
+
+    // Nanoseconds per key to build the container with all keys.
+    template<typename _Container, typename _Key>
+    double insert_ns(const std::vector<_Key>& keys)
+    {
+        return bench::ns_per_op([&keys](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                _Container container;
+                for (std::size_t k = 0; k < keys.size(); ++k) {
+                    container[keys[k]] = k;
+                }
+                bench::keep(container);
+            }
+        }) / static_cast<double>(keys.size());
+    }
+
+    template<typename _Container, typename _Key>
+    double find_ns(const _Container& container, const std::vector<_Key>& keys)
+    {
+        return bench::ns_per_op([&container, &keys](std::size_t n) {
+            std::size_t sum = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += container.find(keys[i % keys.size()])->second;
+            }
+            bench::keep(sum);
+        });
+    }
+
+    // Nanoseconds per element of an in-order scan.
+    template<typename _Container>
+    double scan_ns(const _Container& container)
+    {
+        return bench::ns_per_op([&container](std::size_t n) {
+            std::size_t sum = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                for (const typename _Container::value_type& v : container) {
+                    sum += v.second;
+                }
+            }
+            bench::keep(sum);
+        }) / static_cast<double>(container.size());
+    }
+}
+
+MGSTRINGREF_BENCH(radix_tree)
+{
+    const std::size_t count = 64 * 1024;
+    const std::vector<std::string> strings = make_keys(count);
+    std::vector<mg::stringref> stringrefs;
+    for (const std::string& key : strings) {
+        stringrefs.push_back(mg::stringref(key, mg::stringref::detached));
+    }
+
+    const char* insert = "insert 64K keys";
+    const double baseline_insert = insert_ns<string_map>(strings);
+    bench::report(insert, "std::map<std::string>", baseline_insert, baseline_insert);
+    bench::report(insert, "std::map<stringref>", insert_ns<stringref_map>(stringrefs), baseline_insert);
+    bench::report(insert, "stringref_radix_tree", insert_ns<radix_tree>(stringrefs), baseline_insert);
+
+    string_map by_string;
+    stringref_map by_stringref;
+    radix_tree tree;
+    for (std::size_t k = 0; k < count; ++k) {
+        by_string[strings[k]] = k;
+        by_stringref[stringrefs[k]] = k;
+        tree[stringrefs[k]] = k;
+    }
+
+    const char* find = "find in 64K keys";
+    const double baseline_find = find_ns(by_string, strings);
+    bench::report(find, "std::map<std::string>", baseline_find, baseline_find);
+    bench::report(find, "std::map<stringref>", find_ns(by_stringref, stringrefs), baseline_find);
+    bench::report(find, "stringref_radix_tree", find_ns(tree, stringrefs), baseline_find);
+
+    const char* scan = "in-order scan of 64K keys";
+    const double baseline_scan = scan_ns(by_string);
+    bench::report(scan, "std::map<std::string>", baseline_scan, baseline_scan);
+    bench::report(scan, "std::map<stringref>", scan_ns(by_stringref), baseline_scan);
+    bench::report(scan, "stringref_radix_tree", scan_ns(tree), baseline_scan);
+}
@@ -0,0 +1,73 @@
+#include "mgstringref_bench.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+    // Reference counter with sequentially consistent increment and decrement, the protocol before
+    // atomic_refcount switched to relaxed increments and release decrements.
+    class seq_cst_refcount
+    {
+    public:
+        explicit seq_cst_refcount(int ref) :
+            ref_(ref)
+        {}
+
+        inline void add_ref()
+        {
+            ++ref_;
+        }
+
+        inline bool release()
+        {
+            return (0 == --ref_);
+        }
+
+        inline bool unique() const
+        {
+            return (1 == ref_.load());
+        }
+
+    private:
+        std::atomic<int> ref_;
+    };
+
+    typedef mg::basic_stringref<char, std::char_traits<char>, std::allocator<char>, seq_cst_refcount>
+        seq_cst_stringref;
+
+    // Every thread copies the shared stringref and destroys the copy, so all threads hit the same counter.
+    template<typename _Stringref>
+    double copy_release_ns(const _Stringref& shared, unsigned threads)
+    {
+        return bench::ns_per_op([&shared, threads](std::size_t n) {
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&shared, n, threads]() {
+                    for (std::size_t i = n / threads; 0 != i; --i) {
+                        _Stringref copy(shared);
+                        bench::keep(copy);
+                    }
+                });
+            }
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        });
+    }
+}
+
+// On x86 both protocols compile to the same locked instructions, the difference shows on ARM and POWER.
+MGSTRINGREF_BENCH(refcount_scaling)
+{
+    const char text[] = "Shared string, which is too long to be stored inline";
+    const seq_cst_stringref s1(text, seq_cst_stringref::detached);
+    const mg::stringref s2(text, mg::stringref::detached);
+    const unsigned max_threads = std::max(2u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        char name[64];
+        snprintf(name, sizeof(name), "copy and release, %u threads", threads);
+        const double baseline = copy_release_ns(s1, threads);
+        bench::report(name, "seq_cst", baseline, baseline);
+        bench::report(name, "relaxed/acq_rel", copy_release_ns(s2, threads), baseline);
+    }
+}
@@ -0,0 +1,63 @@
+#include "mgstringref_bench.h"
+
+#include <random>
+#include <string>
+
+namespace {
+    // Stringref padded to the 32 bytes it took before the two-word layout.
+    struct padded_stringref {
+        mg::stringref s_;
+        char pad_[32 - sizeof(mg::stringref)];
+
+        bool operator <(const padded_stringref& other) const
+        {
+            return s_ < other.s_;
+        }
+    };
+
+    // Nanoseconds per element to sort an index array by the items. Items stay in place, so their size decides
+    // how many of them fit the cache.
+    template<typename T>
+    double sort_ns(const std::vector<T>& items)
+    {
+        std::vector<std::size_t> order(items.size());
+        return bench::ns_per_op([&items, &order](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = 0; j < order.size(); ++j) {
+                    order[j] = j;
+                }
+                std::sort(order.begin(), order.end(), [&items](std::size_t a, std::size_t b) {
+                    return items[a] < items[b];
+                });
+                bench::keep(order.front());
+            }
+        }) / static_cast<double>(items.size());
+    }
+}
+
+// Detached strings of up to 15 chars are stored inline, so sorting compares characters in the array itself.
+MGSTRINGREF_BENCH(sort)
+{
+    std::mt19937 rng(42);
+    for (std::size_t count = 1024; count <= 1024 * 1024; count *= 32) {
+        std::vector<std::string> strings;
+        std::vector<mg::stringref> stringrefs;
+        std::vector<padded_stringref> padded;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::string str(4 + rng() % 12, 'a');
+            for (char& c : str) {
+                c = static_cast<char>('a' + rng() % 26);
+            }
+            strings.push_back(str);
+            stringrefs.push_back(mg::stringref(str, mg::stringref::detached));
+            padded.push_back(padded_stringref{stringrefs.back(), {}});
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "sort %zu strings of 4-15 chars", count);
+        const double baseline = sort_ns(strings);
+        bench::report(name, "std::string", baseline, baseline);
+        bench::report(name, "stringref, 32 bytes", sort_ns(padded), baseline);
+        bench::report(name, "stringref, 16 bytes", sort_ns(stringrefs), baseline);
+    }
+}
@@ -0,0 +1,55 @@
+#include "mgstringref_bench.h"
+
+#include <random>
+#include <string>
+
+namespace {
+    // Nanoseconds per haystack character.
+    template<typename _Search>
+    double scan_ns(std::size_t length, _Search search)
+    {
+        return bench::ns_per_op([&search](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                bench::keep(search());
+            }
+        }) / static_cast<double>(length);
+    }
+
+    void report_find(const char* name, const std::string& haystack, const std::string& needle)
+    {
+        const mg::stringref s(haystack);
+        const mg::stringref sneedle(needle);
+        const double baseline = scan_ns(haystack.size(), [&haystack, &needle]() { return haystack.find(needle); });
+        bench::report(name, "std::string", baseline, baseline);
+        bench::report(name, "stringref", scan_ns(haystack.size(), [&s, &sneedle]() { return s.find(sneedle); }),
+                      baseline);
+    }
+}
+
+// Needles of 10 to 60 chars in a megabyte of text. In the adversarial case every position matches all but
+// the last character of the needle.
+MGSTRINGREF_BENCH(find_substring)
+{
+    const std::size_t length = 1024 * 1024;
+    std::mt19937 rng(42);
+    std::string text(length, ' ');
+    for (char& c : text) {
+        c = static_cast<char>('a' + rng() % 26);
+    }
+    const std::string uniform(length, 'a');
+
+    for (std::size_t needle_length = 10; needle_length <= 60; needle_length += 25) {
+        char name[64];
+        snprintf(name, sizeof(name), "random text, %zu chars needle", needle_length);
+        report_find(name, text, std::string(needle_length, 'X'));
+
+        snprintf(name, sizeof(name), "random text, %zu chars suffix", needle_length);
+        report_find(name, text, text.substr(length - needle_length));
+
+        snprintf(name, sizeof(name), "aaa...a, aaa...ab needle of %zu", needle_length);
+        report_find(name, uniform, std::string(needle_length - 1, 'a') + "b");
+
+        snprintf(name, sizeof(name), "aaa...a, baa...a needle of %zu", needle_length);
+        report_find(name, uniform, "b" + std::string(needle_length - 1, 'a'));
+    }
+}
@@ -1,5 +1,16 @@
 if(NOT TARGET mgstringref)
     add_library(mgstringref INTERFACE)
     set_target_properties(mgstringref PROPERTIES INTERFACE_INCLUDE_DIRECTORIES ${CMAKE_CURRENT_LIST_DIR})
-    target_sources(mgstringref INTERFACE ${CMAKE_CURRENT_LIST_DIR}/mgstringref.h)
+    target_sources(mgstringref INTERFACE
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_arena.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_casefold.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_hash.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_intern.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_flat_map.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_perfect_table.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_radix_tree.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_search.h
+        ${CMAKE_CURRENT_LIST_DIR}/mgstringref_matcher.h
+    )
 endif()
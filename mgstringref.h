@@ -1,12 +1,269 @@
+#ifndef MGSTRINGREF_H
+#define MGSTRINGREF_H
+
 #include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
 #include <string>
 #include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <cctype>
 #include <cwctype>
 
+#include "mgstringref_casefold.h"
+#include "mgstringref_hash.h"
+#include "mgstringref_search.h"
+
 namespace mg {
+    // Reference counters for shared data blocks of basic_stringref.
+
+    // Thread-safe reference counter. Used by default.
+    // A new reference is always created from an existing one, so increment needs no ordering. Decrement
+    // releases all previous accesses to the data, and the last owner acquires them before destroying the data.
+    class atomic_refcount
+    {
+    public:
+        explicit atomic_refcount(int ref) :
+            ref_(ref)
+        {}
+
+        inline void add_ref()
+        {
+            ref_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Returns true, if the last reference was released.
+        inline bool release()
+        {
+            if (1 == ref_.fetch_sub(1, std::memory_order_release)) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return true;
+            }
+            return false;
+        }
+
+        // Releases the reference, only if it is not the last one. Returns false, if nothing was released.
+        inline bool release_shared()
+        {
+            int ref = ref_.load(std::memory_order_relaxed);
+            while (ref > 1) {
+                if (ref_.compare_exchange_weak(ref, ref - 1, std::memory_order_release, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Acquire is required here, because the only owner may modify the data after this check.
+        inline bool unique() const
+        {
+            return (1 == ref_.load(std::memory_order_acquire));
+        }
+
+    private:
+        std::atomic<int> ref_;
+    };
+
+    // Reference counter without any synchronization. Stringrefs, which are sharing data, must be used in
+    // the same thread.
+    class single_thread_refcount
+    {
+    public:
+        explicit single_thread_refcount(int ref) :
+            ref_(ref)
+        {}
+
+        inline void add_ref()
+        {
+            ++ref_;
+        }
+
+        inline bool release()
+        {
+            return (0 == (--ref_));
+        }
+
+        inline bool unique() const
+        {
+            return (1 == ref_);
+        }
+
+    private:
+        int ref_;
+    };
+
+    // Same as single_thread_refcount, but asserts, that data is shared and released in the thread
+    // where it was allocated. Intended for debug builds.
+    class thread_checked_refcount
+    {
+    public:
+        explicit thread_checked_refcount(int ref) :
+            ref_(ref), owner_(std::this_thread::get_id())
+        {}
+
+        inline void add_ref()
+        {
+            assert(owner_ == std::this_thread::get_id());
+            ++ref_;
+        }
+
+        inline bool release()
+        {
+            assert(owner_ == std::this_thread::get_id());
+            return (0 == (--ref_));
+        }
+
+        inline bool unique() const
+        {
+            assert(owner_ == std::this_thread::get_id());
+            return (1 == ref_);
+        }
+
+    private:
+        int ref_;
+        std::thread::id owner_;
+    };
+
+    // Reference to a string with static storage duration, with length computed at compile time. It is a literal
+    // type, so it may be used in constexpr tables, and it is implicitly converted to non-detached basic_stringref.
+    template<typename _CharT, typename _Traits = std::char_traits<_CharT> >
+    class basic_stringref_literal
+    {
+    public:
+        typedef _Traits         traits_type;
+        typedef _CharT          value_type;
+        typedef std::size_t     size_type;
+        typedef const _CharT*   const_pointer;
+
+        constexpr basic_stringref_literal() :
+            ptr_(nullptr), len_(0)
+        {}
+
+        // Intended for string literals only: length of the array without terminating zero is used.
+        template<std::size_t N>
+        constexpr basic_stringref_literal(const value_type (&string)[N]) :
+            ptr_(string), len_(N - 1)
+        {}
+
+        constexpr basic_stringref_literal(const_pointer string, size_type size) :
+            ptr_(string), len_(size)
+        {}
+
+        constexpr bool empty() const
+        {
+            return (0 == len_);
+        }
+
+        constexpr size_type size() const
+        {
+            return len_;
+        }
+
+        constexpr const_pointer data() const
+        {
+            return ptr_;
+        }
+
+        constexpr value_type operator [](size_type pos) const
+        {
+            return ptr_[pos];
+        }
+
+        constexpr bool operator ==(const basic_stringref_literal& other) const
+        {
+            return (len_ == other.len_) && __int_equal(ptr_, other.ptr_, len_);
+        }
+
+        constexpr bool operator !=(const basic_stringref_literal& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        static constexpr bool __int_equal(const_pointer s1, const_pointer s2, size_type n)
+        {
+            return (0 == n) || (_Traits::eq(*s1, *s2) && __int_equal(s1 + 1, s2 + 1, n - 1));
+        }
+
+        const_pointer ptr_;
+        size_type len_;
+    };
+
+    // Counters of the content deduplication of detached copies.
+    struct stringref_dedup_stats
+    {
+        // Data blocks in the deduplication set.
+        std::size_t blocks;
+        // Detached copies, which share an existing block instead of allocating a new one.
+        std::size_t hits;
+        // Bytes of characters, which were not allocated thanks to the sharing.
+        std::size_t bytes_saved;
+    };
+
+    // Content deduplication set of detached copies, process-wide. Blocks with whole strings are kept by their
+    // characters, a new copy of a string in the set shares its block. The last release of a block removes it from
+    // the set under the lock of the shard, so a lookup never revives a released block. Stringrefs with different
+    // traits share data blocks, so the set depends only on the characters, the allocator and the reference counter:
+    // the last release may come from other traits, than the ones, which added the block.
+    template<typename _CharT, typename _Alloc, typename _RefCount>
+    struct __int_dedup_set
+    {
+        static constexpr const std::size_t _Shards = 16;
+
+        struct _Key {
+            const _CharT* data_;
+            std::size_t length_;
+            std::size_t hash_;
+        };
+
+        struct _Key_Hash {
+            std::size_t operator ()(const _Key& key) const noexcept
+            {
+                return key.hash_;
+            }
+        };
+
+        struct _Key_Equal {
+            bool operator ()(const _Key& k1, const _Key& k2) const
+            {
+                return (k1.length_ == k2.length_)
+                    && __int_equal_bytes(reinterpret_cast<const unsigned char*>(k1.data_),
+                                         reinterpret_cast<const unsigned char*>(k2.data_),
+                                         k1.length_ * sizeof(_CharT));
+            }
+        };
+
+        // Values are data blocks of basic_stringref, whose type depends on the traits.
+        typedef std::unordered_map<_Key, void*, _Key_Hash, _Key_Equal> _Blocks;
+
+        // Shards are padded, so that mutexes of different shards are not in the same cache line.
+        struct _Shard {
+            std::mutex mutex_;
+            _Blocks blocks_;
+            char pad_[64];
+        };
+
+        std::atomic<bool> enabled_{false};
+        std::atomic<std::size_t> blocks_{0};
+        std::atomic<std::size_t> hits_{0};
+        std::atomic<std::size_t> bytes_saved_{0};
+        _Shard shards_[_Shards];
+
+        // Never destroyed: stringrefs with static storage duration may release their blocks after it.
+        static __int_dedup_set& __int_instance()
+        {
+            static __int_dedup_set* dedup = new __int_dedup_set();
+            return *dedup;
+        }
+    };
+
     template<typename _CharT, typename _Traits = std::char_traits<_CharT>,
-             typename _Alloc = std::allocator<_CharT> >
+             typename _Alloc = std::allocator<_CharT>, typename _RefCount = atomic_refcount>
     class basic_stringref final
     {
         typedef typename std::allocator_traits<_Alloc>::template
@@ -36,6 +293,8 @@ namespace mg {
         typedef value_type const&                       const_reference;
         typedef typename _Alloc_traits::pointer         pointer;
         typedef typename _Alloc_traits::const_pointer   const_pointer;
+        typedef _RefCount                               refcount_type;
+        typedef basic_stringref_literal<_CharT, _Traits> literal;
 
         static constexpr const size_type npos = std::numeric_limits<size_type>::max();
         static constexpr const bool allocator_is_always_equal = __int_is_always_equal<_Alloc>::value;
@@ -43,519 +302,1616 @@ namespace mg {
 
     private:
         struct _Data {
-            constexpr _Data(int ref, size_type allocated) :
-                ref_(ref), allocated_(allocated)
+            _Data(int ref, size_type allocated, unsigned char flags) :
+                ref_(ref), flags_(flags), allocated_(allocated)
             {}
 
-            mutable std::atomic<int> ref_;
+            mutable _RefCount ref_;
+            unsigned char flags_;
+            // Capacity of the block for characters, 0 for adopted strings.
             size_type allocated_;
         };
         static_assert(0 == (sizeof(_Data) % sizeof(value_type)), "Invalid aligment.");
         static constexpr const std::size_t _Data_Header_Len = sizeof(_Data) / sizeof(value_type);
 
-        void __int_construct_nc(const_pointer string, size_type size, size_type offset, size_type length, bool detach)
-        {
-            if (0 != offset) {
-                string += offset;
-                size -= offset;
-            }
+        enum : unsigned char {
+            // Block is in the deduplication set, so it is never modified.
+            _Data_Pooled = 0x01,
+            // Block owns a string object, see _Owner.
+            _Data_Adopted = 0x02
+        };
 
-            if (detach) {
-                pointer data = _Alloc_traits::allocate(a_, _Data_Header_Len + size);
-                d_ = new(data) _Data(1, size);
-                ptr_ = data + _Data_Header_Len;
-                _Traits::copy(data + _Data_Header_Len, string, size);
-            } else {
-                ptr_ = string;
-            }
+        // Blocks of at least 64 bytes keep the hash of their characters after the terminator, 0 if it is not
+        // computed yet. Shorter strings are hashed faster than the cache would be loaded, so they have no cache.
+        typedef std::atomic<std::size_t> _Hash_Cache;
+        static constexpr const size_type _Min_Hashed_Length = 64 / sizeof(value_type);
+        static constexpr const std::size_t _Hash_Align = alignof(_Hash_Cache) / sizeof(value_type);
+        static constexpr const std::size_t _Hash_Len = sizeof(_Hash_Cache) / sizeof(value_type);
+        static_assert((0 != _Hash_Align) && (0 == (sizeof(_Hash_Cache) % sizeof(value_type))), "Invalid aligment.");
 
-            // If lenght == npos, we will use size - offset, because npos is maximum value of size_type
-            len_ = std::min(size, length);
+        // Position of the hash cache in the block, after the terminator.
+        static constexpr size_type __int_hash_pos(size_type allocated)
+        {
+            return (_Data_Header_Len + allocated + _Hash_Align) / _Hash_Align * _Hash_Align;
         }
 
-        inline void __int_construct(const_pointer string, size_type size, size_type offset, size_type length,
-                                    bool detach)
+        // Length of a block with a copy of the characters, including the header and the terminator.
+        static constexpr size_type __int_block_len(size_type allocated)
         {
-            if ((nullptr == string) || (offset >= size) || (0 == length)) {
-                return;
-            }
-            __int_construct_nc(string, size, offset, length, detach);
+            return (allocated < _Min_Hashed_Length) ? (_Data_Header_Len + allocated + 1)
+                : (__int_hash_pos(allocated) + _Hash_Len);
         }
 
-        template<typename _OTraits>
-        void __int_copy_construct(const basic_stringref<value_type, _OTraits, _Alloc>& other, size_type offset,
-                                  size_type length)
+        static _Hash_Cache* __int_hash_cache(const _Data* d)
         {
-            if ((offset >= other.len_) || (0 == length)) {
-                return;
-            }
-            if (other.d_) {
-                if ((!allocator_is_always_equal) && (a_ != other.a_)) {
-                    __int_construct(other.ptr_, other.len_, offset, length, true);
-                    return;
-                }
-                d_ = reinterpret_cast<_Data*>(other.d_);
-                ++(d_->ref_);
-            }
-            ptr_ = other.ptr_ + offset;
-            len_ = std::min(length, other.len_ - offset);
+            return (d->allocated_ < _Min_Hashed_Length) ? nullptr
+                : reinterpret_cast<_Hash_Cache*>(reinterpret_cast<pointer>(const_cast<_Data*>(d))
+                                                 + __int_hash_pos(d->allocated_));
         }
 
-        template<typename _OTraits>
-        void __int_move_construct(basic_stringref<value_type, _OTraits, _Alloc>& other, size_type offset,
-                                  size_type length)
-        {
-            if ((offset < other.len_) && (0 != length)) {
-                d_ = reinterpret_cast<_Data*>(other.d_);
-                ptr_ = other.ptr_ + offset;
-                len_ = std::min(length, other.len_ - offset);
+        // Data block may own a string object moved into it, instead of holding a copy of the characters.
+        // Such blocks have the _Data_Adopted flag and keep _String_Owner right after the header.
+        struct _Owner {
+            void (*destroy_)(_Owner*);
+            size_type length_;
+            const_pointer data_;
+        };
+
+        template<typename _String>
+        struct _String_Owner : public _Owner {
+            explicit _String_Owner(_String&& string, size_type length) :
+                _Owner{&_String_Owner::__int_destroy, length, nullptr}, string_(std::move(string))
+            {
+                this->data_ = string_.data();
             }
-            other.d_ = nullptr;
-            other.ptr_ = nullptr;
-            other.len_ = 0;
-        }
 
-        void __int_release_data(_Data*& d)
-        {
-            if (d && (0 == (--d->ref_))) {
-                d->~_Data();
-                _Alloc_traits::deallocate(a_, reinterpret_cast<pointer>(d), d->allocated_ + _Data_Header_Len);
+            static void __int_destroy(_Owner* owner)
+            {
+                static_cast<_String_Owner*>(owner)->~_String_Owner();
             }
-            d = nullptr;
-        }
 
-        void __int_clear()
+            _String string_;
+        };
+
+        // Offset and length of a shared string, which do not fit the length word. The spill block is owned by
+        // one stringref and holds its reference to the data block.
+        struct _Spill {
+            _Data* d_;
+            size_type offset_;
+            size_type length_;
+        };
+        static constexpr const std::size_t _Spill_Len = (sizeof(_Spill) + sizeof(value_type) - 1) / sizeof(value_type);
+
+        // Stringref is two words long. The first word is the string pointer or the data block pointer,
+        // the second one is the length, with the mode tag in its most significant byte:
+        //   _Tag_Ref     - string is not owned, the second word is the length;
+        //   _Tag_Shared  - string is in the data block, the second word holds the offset of the string in the
+        //                  block (bits 32-60) and the length (bits 0-31). Larger offsets and lengths are kept in
+        //                  a spill block, the first word then points to it and the second one has bit 61 set;
+        //   _Tag_Adopted - same as _Tag_Shared, but the data block owns a string object;
+        //   _Tag_Inline  - short detached string is stored in place of both words, the tag byte holds the length.
+        typedef std::uint64_t _Word;
+
+        struct _Words {
+            union {
+                const_pointer ptr_;
+                _Data* d_;
+                _Spill* s_;
+            };
+            _Word len_;
+        };
+
+        enum : unsigned char {
+            _Tag_Ref = 0x00,
+            _Tag_Shared = 0x40,
+            _Tag_Inline = 0x80,
+            _Tag_Adopted = 0xC0,
+            _Tag_Mask = 0xC0
+        };
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        static constexpr const std::size_t _Tag_Byte = sizeof(_Words) - sizeof(_Word);
+#else
+        static constexpr const std::size_t _Tag_Byte = sizeof(_Words) - 1;
+#endif
+        static constexpr const size_type _Inline_Capacity = _Tag_Byte / sizeof(value_type);
+        static constexpr const _Word _Max_Shared_Length = 0xFFFFFFFFu;
+        static constexpr const _Word _Max_Shared_Offset = 0x1FFFFFFFu;
+        static constexpr const _Word _Spill_Flag = static_cast<_Word>(1) << 61;
+        static constexpr const _Word _Max_Ref_Length = 0x3FFFFFFFFFFFFFFFu;
+        static constexpr const unsigned _Offset_Shift = 32;
+        static constexpr const unsigned _Tag_Shift = 56;
+
+        // Stateless allocators take no space.
+        template<typename _A, bool = std::is_empty<_A>::value>
+        struct __int_alloc_holder {
+            explicit __int_alloc_holder(const _A& a) :
+                a_(a)
+            {}
+
+            _A& __int_alloc() { return a_; }
+            const _A& __int_alloc() const { return a_; }
+
+            _A a_;
+        };
+
+        template<typename _A>
+        struct __int_alloc_holder<_A, true> : private _A {
+            explicit __int_alloc_holder(const _A& a) :
+                _A(a)
+            {}
+
+            _A& __int_alloc() { return *this; }
+            const _A& __int_alloc() const { return *this; }
+        };
+
+        struct _Rep : public __int_alloc_holder<_Char_alloc_type> {
+            explicit _Rep(const _Char_alloc_type& a) :
+                __int_alloc_holder<_Char_alloc_type>(a), words_()
+            {}
+
+            union {
+                _Words words_;
+                value_type buf_[_Inline_Capacity];
+                unsigned char bytes_[sizeof(_Words)];
+            };
+        };
+
+        // Content deduplication of detached copies, see __int_dedup_set. Blocks are shared between threads, so it
+        // requires atomic_refcount, and between stringrefs, so the allocator must be always equal.
+        static constexpr const bool _Dedup_Supported = allocator_is_always_equal
+            && std::is_same<_RefCount, atomic_refcount>::value;
+        // Code of the deduplication is instantiated only for supported types, other reference counters need no
+        // release_shared().
+        typedef std::integral_constant<bool, _Dedup_Supported> _Dedup_Tag;
+
+        typedef __int_dedup_set<value_type, _Alloc, _RefCount> _Dedup;
+
+        static _Dedup& __int_dedup()
         {
-            __int_release_data(d_);
-            ptr_ = nullptr;
-            len_ = 0;
+            return _Dedup::__int_instance();
         }
 
-        basic_stringref& __int_assign(const_pointer string, size_type size, size_type offset, size_type length,
-                                      bool detach)
+        // Tag byte is the most significant byte of the length word on any byte order.
+        inline unsigned char __int_tag_byte() const
         {
-            // TODO: check for we can reuse allocated data.
-            __int_clear();
-            __int_construct(string, size, offset, length, detach);
-            return *this;
+            return static_cast<unsigned char>(rep_.words_.len_ >> _Tag_Shift);
         }
 
-        template<typename _OTraits>
-        basic_stringref& __int_copy_assign(const basic_stringref<value_type, _OTraits, _Alloc>& other,
-                                           size_type offset, size_type length, bool copy_detach)
+        inline unsigned char __int_tag() const
         {
-            if ((offset >= other.len_) || (0 == length)) {
-                __int_clear();
-            } else if (copy_detach) {
-                // TODO: check for we can reuse allocated data.
-                __int_clear();
-                __int_construct_nc(other.ptr_, other.len_, offset, length, true);
-            } else if (!other.d_) {
-                __int_clear();
-                __int_construct_nc(other.ptr_, other.len_, offset, length, false);
-            } else {
-                if ((!allocator_is_always_equal) && (a_ != other.a_)) {
-                    // TODO: check for we can reuse allocated data.
-                    __int_clear();
-                    __int_construct_nc(other.ptr_, other.len_, offset, length, true);
-                } else {
-                    __int_release_data(d_);
-                    d_ = reinterpret_cast<_Data*>(other.d_);
-                    ++(d_->ref_);
-                    ptr_ = other.ptr_ + offset;
-                    len_ = std::min(length, other.len_ - offset);
-                }
-            }
-            return *this;
+            return __int_tag_byte() & _Tag_Mask;
         }
 
-        static size_type __int_strlen(const_pointer string)
+        // Returns true for both _Tag_Shared and _Tag_Adopted.
+        inline bool __int_is_shared() const
         {
-            return (nullptr == string) ? 0 : _Traits::length(string);
+            return (0 != (__int_tag_byte() & _Tag_Shared));
         }
 
-        static int __int_compare(const_pointer s1, size_type size1, const_pointer s2, size_t size2)
+        // Spill state, data block, offset and length of a shared string.
+        inline bool __int_is_spilled() const
         {
-            int result = _Traits::compare(s1, s2, std::min(size1, size2));
-            if (size1 == size2) {
-                return result;
-            } else {
-                return result ? result : (size1 < size2) ? (-1) : 1;
-            }
+            return (0 != (rep_.words_.len_ & _Spill_Flag));
         }
 
-    public:
-        explicit basic_stringref(const _Alloc& a = _Alloc()) :
-            a_(a)
-        {}
-
-        explicit basic_stringref(const_pointer string, const _Alloc& a = _Alloc()) :
-            a_(a)
+        inline _Data* __int_data() const
         {
-            __int_construct(string, __int_strlen(string), 0, npos, false);
+            return __int_is_spilled() ? rep_.words_.s_->d_ : rep_.words_.d_;
         }
 
-        basic_stringref(const_pointer string, std::true_type, const _Alloc& a = _Alloc()) :
-            a_(a)
+        inline size_type __int_offset() const
         {
-            __int_construct(string, __int_strlen(string), 0, npos, true);
+            return __int_is_spilled() ? rep_.words_.s_->offset_
+                : static_cast<size_type>((rep_.words_.len_ >> _Offset_Shift) & _Max_Shared_Offset);
         }
 
-        basic_stringref(const_pointer string, size_type size, const _Alloc& a = _Alloc()) :
-            a_(a)
+        inline size_type __int_length() const
         {
-            __int_construct(string, size, 0, size, false);
+            return __int_is_spilled() ? rep_.words_.s_->length_
+                : static_cast<size_type>(rep_.words_.len_ & _Max_Shared_Length);
         }
 
-        basic_stringref(const_pointer string, size_type size, std::true_type, const _Alloc& a = _Alloc()) :
-            a_(a)
+        static const_pointer __int_block_data(const _Data* d, unsigned char tag)
         {
-            __int_construct(string, size, 0, size, true);
+            return (_Tag_Adopted == tag)
+                ? reinterpret_cast<const _Owner*>(reinterpret_cast<const_pointer>(d) + _Data_Header_Len)->data_
+                : reinterpret_cast<const_pointer>(d) + _Data_Header_Len;
         }
 
-        basic_stringref(const_pointer string, size_type offset, size_type length, const _Alloc& a = _Alloc()) :
-            a_(a)
+        // Length of a string in memory never reaches the tag bits. Masking makes it known to the compiler, which
+        // then sees, that the string is not owned.
+        inline void __int_set_ref(const_pointer string, size_type length)
         {
-            __int_construct(string, __int_strlen(string), offset, length, false);
+            rep_.words_.ptr_ = string;
+            rep_.words_.len_ = static_cast<_Word>(length) & _Max_Ref_Length;
         }
 
-        basic_stringref(const_pointer string, size_type offset, size_type length, std::true_type, const _Alloc& a = _Alloc()) :
-            a_(a)
+        // Takes over a reference to the data block, which is released, if the spill block can not be allocated.
+        inline void __int_set_shared(_Data* d, unsigned char tag, size_type offset, size_type length)
         {
-            __int_construct(string, __int_strlen(string), offset, length, true);
+            if ((static_cast<_Word>(offset) > _Max_Shared_Offset)
+                || (static_cast<_Word>(length) > _Max_Shared_Length)) {
+                __int_set_spilled(d, tag, offset, length);
+                return;
+            }
+            rep_.words_.d_ = d;
+            rep_.words_.len_ = (static_cast<_Word>(tag) << _Tag_Shift) | (static_cast<_Word>(offset) << _Offset_Shift)
+                | static_cast<_Word>(length);
         }
 
-        basic_stringref(const_pointer string, size_type size, size_type offset, size_type length,
-                        const _Alloc& a = _Alloc()) :
-            a_(a)
+        void __int_set_spilled(_Data* d, unsigned char tag, size_type offset, size_type length)
         {
-            __int_construct(string, size, offset, length, false);
+            pointer p;
+            try {
+                p = _Alloc_traits::allocate(rep_.__int_alloc(), _Spill_Len);
+            } catch (...) {
+                __int_release_data(d);
+                throw;
+            }
+            rep_.words_.s_ = new(p) _Spill{d, offset, length};
+            rep_.words_.len_ = (static_cast<_Word>(tag) << _Tag_Shift) | _Spill_Flag;
         }
 
-        basic_stringref(const_pointer string, size_type size, size_type offset, size_type length,
-                        std::true_type, const _Alloc& a = _Alloc()) :
-            a_(a)
+        // The string may point into the inline buffer itself. Terminator is stored, if there is space for it.
+        inline void __int_set_inline(const_pointer string, size_type length)
         {
-            __int_construct(string, size, offset, length, true);
+            _Traits::move(rep_.buf_, string, length);
+            if (length < _Inline_Capacity) {
+                _Traits::assign(rep_.buf_[length], value_type());
+            }
+            rep_.bytes_[_Tag_Byte] = static_cast<unsigned char>(_Tag_Inline | length);
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        explicit basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
-                                 const _Alloc& a = _Alloc()) :
-            a_(a)
+        void __int_construct_nc(const_pointer string, size_type size, size_type offset, size_type length, bool detach)
         {
-            __int_construct(string.data(), string.size(), 0, npos, false);
+            if (0 != offset) {
+                string += offset;
+                size -= offset;
+            }
+
+            // If lenght == npos, we will use size - offset, because npos is maximum value of size_type
+            size_type len = std::min(size, length);
+
+            if (!detach) {
+                __int_set_ref(string, len);
+            } else if (len <= _Inline_Capacity) {
+                __int_set_inline(string, len);
+            } else {
+                __int_allocate(string, len);
+            }
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        explicit basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
-                                 std::true_type, const _Alloc& a = _Alloc()) :
-            a_(a)
+        // Copies string into a new data block. Block has one extra slot for the terminator.
+        void __int_allocate(const_pointer string, size_type length)
         {
-            __int_construct(string.data(), string.size(), 0, npos, true);
+            __int_allocate(string, length, _Dedup_Tag());
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string, size_type offset,
-                        size_type length, const _Alloc& a = _Alloc()) :
-            a_(a)
+        void __int_allocate(const_pointer string, size_type length, std::true_type)
         {
-            __int_construct(string.data(), string.size(), offset, length, false);
+            if (__int_dedup().enabled_.load(std::memory_order_relaxed)) {
+                __int_allocate_pooled(string, length);
+                return;
+            }
+            __int_allocate(string, length, std::false_type());
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string, size_type offset,
-                        size_type length, std::true_type, const _Alloc& a = _Alloc()) :
-            a_(a)
+        void __int_allocate(const_pointer string, size_type length, std::false_type)
         {
-            __int_construct(string.data(), string.size(), offset, length, true);
+            __int_set_shared(__int_new_block(string, length, 0), _Tag_Shared, 0, length);
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        explicit basic_stringref(std::basic_string<value_type, _OTraits, _OAlloc>&& string,
-                                 const _Alloc& a = _Alloc()) :
-            a_(a)
+        _Data* __int_new_block(const_pointer string, size_type length, unsigned char flags)
         {
-            __int_construct(string.data(), string.size(), 0, npos, true);
+            pointer data = _Alloc_traits::allocate(rep_.__int_alloc(), __int_block_len(length));
+            _Data* d = new(data) _Data(1, length, flags);
+            _Traits::copy(data + _Data_Header_Len, string, length);
+            _Traits::assign(data[_Data_Header_Len + length], value_type());
+            if (length >= _Min_Hashed_Length) {
+                new(data + __int_hash_pos(length)) _Hash_Cache(0);
+            }
+            return d;
+        }
+
+        // Shares the block of an equal string from the deduplication set, or adds a new block to the set.
+        void __int_allocate_pooled(const_pointer string, size_type length)
+        {
+            const std::size_t h = static_cast<std::size_t>(__int_wyhash::hash(string, length * sizeof(value_type)));
+            _Dedup& dedup = __int_dedup();
+            typename _Dedup::_Shard& shard = dedup.shards_[h % _Dedup::_Shards];
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            typename _Dedup::_Blocks::iterator it = shard.blocks_.find(typename _Dedup::_Key{string, length, h});
+            if (shard.blocks_.end() != it) {
+                _Data* d = static_cast<_Data*>(it->second);
+                d->ref_.add_ref();
+                __int_set_shared(d, _Tag_Shared, 0, length);
+                dedup.hits_.fetch_add(1, std::memory_order_relaxed);
+                dedup.bytes_saved_.fetch_add(length * sizeof(value_type), std::memory_order_relaxed);
+                return;
+            }
+            _Data* d = __int_new_block(string, length, _Data_Pooled);
+            if (_Hash_Cache* cached = __int_hash_cache(d)) {
+                cached->store(h, std::memory_order_relaxed);
+            }
+            try {
+                shard.blocks_.emplace(typename _Dedup::_Key{reinterpret_cast<pointer>(d) + _Data_Header_Len, length, h},
+                                      d);
+            } catch (...) {
+                __int_free_data(d);
+                throw;
+            }
+            dedup.blocks_.fetch_add(1, std::memory_order_relaxed);
+            __int_set_shared(d, _Tag_Shared, 0, length);
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        basic_stringref(std::basic_string<value_type, _OTraits, _OAlloc>&& string, size_type offset, size_type length,
+        // Copies string into the storage owned by this stringref: inline buffer, or data block, if this
+        // stringref is the only owner of the block. The string may point into the storage itself.
+        bool __int_reuse_data(const_pointer string, size_type size, size_type offset, size_type length)
+        {
+            size_type len = std::min(size - offset, length);
+            unsigned char tag = __int_tag();
+            if (_Tag_Inline == tag) {
+                if (len > _Inline_Capacity) {
+                    return false;
+                }
+                __int_set_inline(string + offset, len);
+                return true;
+            }
+
+            if ((_Tag_Shared != tag) || __int_is_spilled()) {
+                return false;
+            }
+            _Data* d = rep_.words_.d_;
+            if ((0 != (d->flags_ & _Data_Pooled)) || (!d->ref_.unique()) || (d->allocated_ < len)) {
+                return false;
+            }
+            pointer data = reinterpret_cast<pointer>(d) + _Data_Header_Len;
+            _Traits::move(data, string + offset, len);
+            _Traits::assign(data[len], value_type());
+            if (_Hash_Cache* cached = __int_hash_cache(d)) {
+                cached->store(0, std::memory_order_relaxed);
+            }
+            __int_set_shared(d, _Tag_Shared, 0, len);
+            return true;
+        }
+
+        // Makes detached copy of the string. The string may point into the storage of this stringref.
+        void __int_assign_detached(const_pointer string, size_type size, size_type offset, size_type length)
+        {
+            if (!__int_reuse_data(string, size, offset, length)) {
+                basic_stringref tmp(rep_.__int_alloc());
+                tmp.__int_construct_nc(string, size, offset, length, true);
+                __int_clear();
+                __int_steal(tmp);
+            }
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        void __int_adopt(std::basic_string<value_type, _OTraits, _OAlloc>&& string, size_type offset,
+                         size_type length)
+        {
+            if ((offset >= string.size()) || (0 == length)) {
+                return;
+            }
+            size_type len = std::min(string.size() - offset, length);
+            if (len <= _Inline_Capacity) {
+                __int_construct_nc(string.data(), string.size(), offset, length, true);
+                return;
+            }
+
+            typedef _String_Owner<std::basic_string<value_type, _OTraits, _OAlloc> > _Owner_Type;
+            static_assert(alignof(_Owner_Type) <= alignof(_Data), "Invalid aligment.");
+            const size_type block_len = _Data_Header_Len + (sizeof(_Owner_Type) + sizeof(value_type) - 1)
+                / sizeof(value_type);
+            pointer data = _Alloc_traits::allocate(rep_.__int_alloc(), block_len);
+            new(data + _Data_Header_Len) _Owner_Type(std::move(string), block_len);
+            __int_set_shared(new(data) _Data(1, 0, _Data_Adopted), _Tag_Adopted, offset, len);
+        }
+
+        inline void __int_construct(const_pointer string, size_type size, size_type offset, size_type length,
+                                    bool detach)
+        {
+            if ((nullptr == string) || (offset >= size) || (0 == length)) {
+                return;
+            }
+            __int_construct_nc(string, size, offset, length, detach);
+        }
+
+        // Shares data block of other stringref, which must be shared and have the same allocator.
+        template<typename _OTraits>
+        void __int_share(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other, size_type offset,
+                         size_type length)
+        {
+            _Data* d = reinterpret_cast<_Data*>(other.__int_data());
+            d->ref_.add_ref();
+            __int_set_shared(d, other.__int_tag(), offset + other.__int_offset(), length);
+        }
+
+        template<typename _OTraits>
+        void __int_copy_construct(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other,
+                                  size_type offset, size_type length)
+        {
+            if ((offset >= other.size()) || (0 == length)) {
+                return;
+            }
+            length = std::min(length, other.size() - offset);
+            switch (other.__int_tag()) {
+            case _Tag_Ref:
+                __int_set_ref(other.rep_.words_.ptr_ + offset, length);
+                break;
+            case _Tag_Inline:
+                __int_set_inline(other.rep_.buf_ + offset, length);
+                break;
+            default:
+                if ((!allocator_is_always_equal) && (rep_.__int_alloc() != other.rep_.__int_alloc())) {
+                    __int_construct_nc(other.data(), other.size(), offset, length, true);
+                } else {
+                    __int_share(other, offset, length);
+                }
+                break;
+            }
+        }
+
+        void __int_steal(basic_stringref& other)
+        {
+            rep_.words_ = other.rep_.words_;
+            other.rep_.words_ = _Words();
+        }
+
+        template<typename _OTraits>
+        void __int_move_construct(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other, size_type offset,
+                                  size_type length)
+        {
+            if ((offset < other.size()) && (0 != length)) {
+                length = std::min(length, other.size() - offset);
+                unsigned char tag = other.__int_tag();
+                if ((0 != (tag & _Tag_Shared)) && other.__int_is_spilled()) {
+                    // The spill block is taken over, so moving never allocates.
+                    rep_.words_.s_ = reinterpret_cast<_Spill*>(other.rep_.words_.s_);
+                    rep_.words_.len_ = other.rep_.words_.len_;
+                    rep_.words_.s_->offset_ += offset;
+                    rep_.words_.s_->length_ = length;
+                    other.rep_.words_ = typename basic_stringref<value_type, _OTraits, _Alloc, _RefCount>::_Words();
+                    return;
+                }
+                if ((0 != (tag & _Tag_Shared)) && ((offset + other.__int_offset()) <= _Max_Shared_Offset)) {
+                    __int_set_shared(reinterpret_cast<_Data*>(other.rep_.words_.d_), tag,
+                                     offset + other.__int_offset(), length);
+                    other.rep_.words_ = typename basic_stringref<value_type, _OTraits, _Alloc, _RefCount>::_Words();
+                    return;
+                }
+                __int_copy_construct(other, offset, length);
+            }
+            other.__int_clear();
+        }
+
+        void __int_release_data(_Data* d)
+        {
+            __int_release_data(d, _Dedup_Tag());
+        }
+
+        void __int_release_data(_Data* d, std::true_type)
+        {
+            if (0 != (d->flags_ & _Data_Pooled)) {
+                __int_release_pooled(d);
+            } else {
+                __int_release_data(d, std::false_type());
+            }
+        }
+
+        void __int_release_data(_Data* d, std::false_type)
+        {
+            if (d->ref_.release()) {
+                __int_free_data(d);
+            }
+        }
+
+        // Only the last reference is released under the lock of the shard.
+        void __int_release_pooled(_Data* d)
+        {
+            if (d->ref_.release_shared()) {
+                return;
+            }
+            _Dedup& dedup = __int_dedup();
+            const std::size_t h = __int_block_hash(d);
+            typename _Dedup::_Shard& shard = dedup.shards_[h % _Dedup::_Shards];
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex_);
+                if (!d->ref_.release()) {
+                    return;
+                }
+                const_pointer data = reinterpret_cast<const_pointer>(d) + _Data_Header_Len;
+                shard.blocks_.erase(typename _Dedup::_Key{data, d->allocated_, h});
+            }
+            dedup.blocks_.fetch_sub(1, std::memory_order_relaxed);
+            __int_free_data(d);
+        }
+
+        void __int_free_data(_Data* d)
+        {
+            size_type block_len = __int_block_len(d->allocated_);
+            if (0 != (d->flags_ & _Data_Adopted)) {
+                _Owner* owner = reinterpret_cast<_Owner*>(reinterpret_cast<pointer>(d) + _Data_Header_Len);
+                block_len = owner->length_;
+                owner->destroy_(owner);
+            }
+            d->~_Data();
+            _Alloc_traits::deallocate(rep_.__int_alloc(), reinterpret_cast<pointer>(d), block_len);
+        }
+
+        // Releases the data block of a shared string and frees its spill block.
+        void __int_release()
+        {
+            _Data* d = rep_.words_.d_;
+            if (__int_is_spilled()) {
+                _Spill* s = rep_.words_.s_;
+                d = s->d_;
+                s->~_Spill();
+                _Alloc_traits::deallocate(rep_.__int_alloc(), reinterpret_cast<pointer>(s), _Spill_Len);
+            }
+            __int_release_data(d);
+        }
+
+        void __int_clear()
+        {
+            if (__int_is_shared()) {
+                __int_release();
+            }
+            rep_.words_ = _Words();
+        }
+
+        basic_stringref& __int_assign(const_pointer string, size_type size, size_type offset, size_type length,
+                                      bool detach)
+        {
+            if ((nullptr == string) || (offset >= size) || (0 == length)) {
+                __int_clear();
+            } else if (detach) {
+                __int_assign_detached(string, size, offset, length);
+            } else {
+                __int_clear();
+                __int_construct_nc(string, size, offset, length, false);
+            }
+            return *this;
+        }
+
+        template<typename _OTraits>
+        basic_stringref& __int_copy_assign(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other,
+                                           size_type offset, size_type length, bool copy_detach)
+        {
+            if ((offset >= other.size()) || (0 == length)) {
+                __int_clear();
+                return *this;
+            }
+            unsigned char tag = other.__int_tag();
+            if (copy_detach || (_Tag_Inline == tag)
+                || ((0 != (tag & _Tag_Shared)) && (!allocator_is_always_equal)
+                    && (rep_.__int_alloc() != other.rep_.__int_alloc()))) {
+                __int_assign_detached(other.data(), other.size(), offset, length);
+            } else {
+                // Build the result first: other may be this stringref.
+                basic_stringref tmp(rep_.__int_alloc());
+                tmp.__int_copy_construct(other, offset, length);
+                __int_clear();
+                __int_steal(tmp);
+            }
+            return *this;
+        }
+
+        // Takes data block of other stringref, if allocators are equal. Not owned string is copied only if
+        // copy_detach is set.
+        template<typename _OTraits>
+        basic_stringref& __int_move_assign(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other,
+                                           size_type offset, size_type length, bool copy_detach)
+        {
+            // Build the result first: other may be this stringref.
+            basic_stringref tmp(rep_.__int_alloc());
+            if (copy_detach && (_Tag_Ref == other.__int_tag())) {
+                tmp.__int_construct(other.data(), other.size(), offset, length, true);
+            } else if (allocator_is_always_equal || (rep_.__int_alloc() == other.rep_.__int_alloc())) {
+                tmp.__int_move_construct(other, offset, length);
+            } else {
+                tmp.__int_copy_construct(other, offset, length);
+            }
+            other.__int_clear();
+            __int_clear();
+            __int_steal(tmp);
+            return *this;
+        }
+
+        void __int_swap_alloc(basic_stringref& other, std::true_type)
+        {
+            std::swap(rep_.__int_alloc(), other.rep_.__int_alloc());
+        }
+
+        void __int_swap_alloc(basic_stringref& other, std::false_type)
+        {
+            (void)other;
+            assert(allocator_is_always_equal || (rep_.__int_alloc() == other.rep_.__int_alloc()));
+        }
+
+        typedef __int_search<_Traits> _Search;
+
+        static size_type __int_found(std::size_t index, size_type pos)
+        {
+            return (_Search::npos == index) ? npos : static_cast<size_type>(pos + index);
+        }
+
+        static size_type __int_strlen(const_pointer string)
+        {
+            return (nullptr == string) ? 0 : _Traits::length(string);
+        }
+
+        // Hash of the string, which covers the whole data block, is cached in long blocks. Only plain traits use it:
+        // the block may be shared with stringrefs of other traits.
+        std::size_t __int_hash(std::true_type) const
+        {
+            if ((_Tag_Shared == __int_tag()) && (0 == __int_offset()) && (size() == __int_data()->allocated_)) {
+                return __int_block_hash(__int_data());
+            }
+            return static_cast<std::size_t>(__int_wyhash::hash(data(), size() * sizeof(value_type)));
+        }
+
+        // Hash of all characters of a block with a copy of the string, cached, if the block has the cache.
+        static std::size_t __int_block_hash(const _Data* d)
+        {
+            const_pointer data = reinterpret_cast<const_pointer>(d) + _Data_Header_Len;
+            _Hash_Cache* cached = __int_hash_cache(d);
+            if (nullptr == cached) {
+                return static_cast<std::size_t>(__int_wyhash::hash(data, d->allocated_ * sizeof(value_type)));
+            }
+            std::size_t h = cached->load(std::memory_order_relaxed);
+            if (0 == h) {
+                h = static_cast<std::size_t>(__int_wyhash::hash(data, d->allocated_ * sizeof(value_type)));
+                cached->store(h, std::memory_order_relaxed);
+            }
+            return h;
+        }
+
+        std::size_t __int_hash(std::false_type) const
+        {
+            return static_cast<std::size_t>(__int_hash_folded<_Traits>(data(), size()));
+        }
+
+        static int __int_compare(const_pointer s1, size_type size1, const_pointer s2, size_t size2)
+        {
+            int result = _Traits::compare(s1, s2, std::min(size1, size2));
+            if (size1 == size2) {
+                return result;
+            } else {
+                return result ? result : (size1 < size2) ? (-1) : 1;
+            }
+        }
+
+    public:
+        explicit basic_stringref(const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {}
+
+        explicit basic_stringref(const_pointer string, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string, __int_strlen(string), 0, npos, false);
+        }
+
+        basic_stringref(const_pointer string, std::true_type, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string, __int_strlen(string), 0, npos, true);
+        }
+
+        basic_stringref(const_pointer string, size_type size, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string, size, 0, size, false);
+        }
+
+        basic_stringref(const_pointer string, size_type size, std::true_type, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string, size, 0, size, true);
+        }
+
+        basic_stringref(const_pointer string, size_type offset, size_type length, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string, __int_strlen(string), offset, length, false);
+        }
+
+        basic_stringref(const_pointer string, size_type offset, size_type length, std::true_type, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string, __int_strlen(string), offset, length, true);
+        }
+
+        basic_stringref(const_pointer string, size_type size, size_type offset, size_type length,
                         const _Alloc& a = _Alloc()) :
-            a_(a)
+            rep_(a)
+        {
+            __int_construct(string, size, offset, length, false);
+        }
+
+        basic_stringref(const_pointer string, size_type size, size_type offset, size_type length,
+                        std::true_type, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string, size, offset, length, true);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        explicit basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
+                                 const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string.data(), string.size(), 0, npos, false);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        explicit basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
+                                 std::true_type, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string.data(), string.size(), 0, npos, true);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string, size_type offset,
+                        size_type length, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(string.data(), string.size(), offset, length, false);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        basic_stringref(const std::basic_string<value_type, _OTraits, _OAlloc>& string, size_type offset,
+                        size_type length, std::true_type, const _Alloc& a = _Alloc()) :
+            rep_(a)
         {
             __int_construct(string.data(), string.size(), offset, length, true);
         }
 
+        // Takes ownership of the string, without copying its characters.
+        template<typename _OTraits, typename _OAlloc>
+        explicit basic_stringref(std::basic_string<value_type, _OTraits, _OAlloc>&& string,
+                                 const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_adopt(std::move(string), 0, npos);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        basic_stringref(std::basic_string<value_type, _OTraits, _OAlloc>&& string, size_type offset, size_type length,
+                        const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_adopt(std::move(string), offset, length);
+        }
+
+        template<typename _OTraits>
+        basic_stringref(const basic_stringref_literal<value_type, _OTraits>& literal, const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(literal.data(), literal.size(), 0, npos, false);
+        }
+
+        template<typename _OTraits>
+        basic_stringref(const basic_stringref_literal<value_type, _OTraits>& literal, std::true_type,
+                        const _Alloc& a = _Alloc()) :
+            rep_(a)
+        {
+            __int_construct(literal.data(), literal.size(), 0, npos, true);
+        }
+
         basic_stringref(const basic_stringref& other) :
-            a_(_Alloc_traits::select_on_container_copy_construction(other.a_))
+            rep_(_Alloc_traits::select_on_container_copy_construction(other.rep_.__int_alloc()))
         {
-            __int_copy_construct(other, 0, other.len_);
+            __int_copy_construct(other, 0, other.size());
         }
 
         basic_stringref(const basic_stringref& other, size_type offset, size_type length) :
-            a_(_Alloc_traits::select_on_container_copy_construction(other.a_))
+            rep_(_Alloc_traits::select_on_container_copy_construction(other.rep_.__int_alloc()))
         {
             __int_copy_construct(other, offset, length);
         }
 
         template<typename _OTraits>
-        explicit basic_stringref(const basic_stringref<value_type, _OTraits, _Alloc>& other) :
-            a_(_Alloc_traits::select_on_container_copy_construction(other.a_))
+        explicit basic_stringref(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other) :
+            rep_(_Alloc_traits::select_on_container_copy_construction(other.rep_.__int_alloc()))
         {
-            __int_copy_construct(other, 0, other.len_);
+            __int_copy_construct(other, 0, other.size());
         }
 
         template<typename _OTraits>
-        basic_stringref(const basic_stringref<value_type, _OTraits, _Alloc>& other, size_type offset,
+        basic_stringref(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other, size_type offset,
                         size_type length) :
-            a_(_Alloc_traits::select_on_container_copy_construction(other.a_))
+            rep_(_Alloc_traits::select_on_container_copy_construction(other.rep_.__int_alloc()))
         {
             __int_copy_construct(other, offset, length);
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        explicit basic_stringref(const basic_stringref<value_type, _OTraits, _OAlloc>& string,
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        explicit basic_stringref(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string,
                                  const _Alloc& a = _Alloc()) :
-            a_(a)
+            rep_(a)
         {
             __int_construct(string.data(), string.size(), 0, npos, string.is_detached());
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        basic_stringref(const basic_stringref<value_type, _OTraits, _OAlloc>& string, size_type offset,
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        basic_stringref(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string, size_type offset,
                         size_type length, const _Alloc& a = _Alloc()) :
-            a_(a)
+            rep_(a)
+        {
+            __int_construct(string.data(), string.size(), offset, length, string.is_detached());
+        }
+
+        basic_stringref(basic_stringref&& other) noexcept :
+            rep_(other.rep_.__int_alloc())
+        {
+            __int_move_construct(other, 0, other.size());
+        }
+
+        basic_stringref(basic_stringref&& other, size_type offset, size_type length) :
+            rep_(other.rep_.__int_alloc())
+        {
+            __int_move_construct(other, offset, length);
+        }
+
+        template<typename _OTraits>
+        explicit basic_stringref(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>&& other) :
+            rep_(other.rep_.__int_alloc())
+        {
+            __int_move_construct(other, 0, other.size());
+        }
+
+        template<typename _OTraits>
+        basic_stringref(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>&& other, size_type offset, size_type length) :
+            rep_(other.rep_.__int_alloc())
+        {
+            __int_move_construct(other, offset, length);
+        }
+
+        ~basic_stringref()
+        {
+            if (__int_is_shared()) {
+                __int_release();
+            }
+        }
+
+        inline basic_stringref& assign(const_pointer string)
+        {
+            return __int_assign(string, __int_strlen(string), 0, npos, false);
+        }
+
+        inline basic_stringref& assign(const_pointer string, std::true_type)
+        {
+            return __int_assign(string, __int_strlen(string), 0, npos, true);
+        }
+
+        inline basic_stringref& assign(const_pointer string, size_type size)
+        {
+            return __int_assign(string, size, 0, npos, false);
+        }
+
+        inline basic_stringref& assign(const_pointer string, size_type size, std::true_type)
+        {
+            return __int_assign(string, size, 0, npos, true);
+        }
+
+        inline basic_stringref& assign(const_pointer string, size_type offset, size_type length)
+        {
+            return __int_assign(string, __int_strlen(string), offset, length, false);
+        }
+
+        inline basic_stringref& assign(const_pointer string, size_type offset, size_type length, std::true_type)
+        {
+            return __int_assign(string, __int_strlen(string), offset, length, true);
+        }
+
+        inline basic_stringref& assign(const_pointer string, size_type size, size_type offset, size_type length)
+        {
+            return __int_assign(string, size, offset, length, false);
+        }
+
+        inline basic_stringref& assign(const_pointer string, size_type size, size_type offset, size_type length,
+                                       std::true_type)
+        {
+            return __int_assign(string, size, offset, length, true);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string)
+        {
+            return __int_assign(string.data(), string.size(), 0, npos, false);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string, std::true_type)
+        {
+            return __int_assign(string.data(), string.size(), 0, npos, true);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
+                                       size_type offset, size_type length)
+        {
+            return __int_assign(string.data(), string.size(), offset, length, false);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
+                                       size_type offset, size_type length, std::true_type)
+        {
+            return __int_assign(string.data(), string.size(), offset, length, true);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline basic_stringref& assign(std::basic_string<value_type, _OTraits, _OAlloc>&& string)
+        {
+            return assign(std::move(string), 0, npos);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        basic_stringref& assign(std::basic_string<value_type, _OTraits, _OAlloc>&& string, size_type offset,
+                                size_type length)
+        {
+            if ((offset < string.size()) && (0 != length)
+                && (std::min(string.size() - offset, length) <= _Inline_Capacity)) {
+                return __int_assign(string.data(), string.size(), offset, length, true);
+            }
+            __int_clear();
+            __int_adopt(std::move(string), offset, length);
+            return *this;
+        }
+
+        template<typename _OTraits>
+        inline basic_stringref& assign(const basic_stringref_literal<value_type, _OTraits>& literal)
+        {
+            return __int_assign(literal.data(), literal.size(), 0, npos, false);
+        }
+
+        template<typename _OTraits>
+        inline basic_stringref& assign(const basic_stringref_literal<value_type, _OTraits>& literal, std::true_type)
+        {
+            return __int_assign(literal.data(), literal.size(), 0, npos, true);
+        }
+
+        basic_stringref& assign(const basic_stringref& other)
+        {
+            return __int_copy_assign(other, 0, npos, false);
+        }
+
+        basic_stringref& assign(const basic_stringref& other, std::true_type)
+        {
+            return __int_copy_assign(other, 0, npos, true);
+        }
+
+        basic_stringref& assign(const basic_stringref& other, size_type offset, size_type length)
+        {
+            return __int_copy_assign(other, offset, length, false);
+        }
+
+        basic_stringref& assign(const basic_stringref& other, size_type offset, size_type length, std::true_type)
+        {
+            return __int_copy_assign(other, offset, length, true);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other)
+        {
+            return __int_copy_assign(other, 0, npos, false);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other, std::true_type)
+        {
+            return __int_copy_assign(other, 0, npos, true);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other, size_type offset,
+                                size_type length)
+        {
+            return __int_copy_assign(other, offset, length, false);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc, _RefCount>& other, size_type offset,
+                                size_type length, std::true_type)
+        {
+            return __int_copy_assign(other, offset, length, true);
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& other)
+        {
+            return __int_assign(other.data(), other.size(), 0, npos, other.is_detached());
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& other,
+                                       std::true_type)
+        {
+            return __int_assign(other.data(), other.size(), 0, npos, true);
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& other,
+                                       size_type offset, size_type length)
+        {
+            return __int_assign(other.data(), other.size(), offset, length, other.is_detached());
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& other,
+                                       size_type offset, size_type length, std::true_type)
+        {
+            return __int_assign(other.data(), other.size(), offset, length, true);
+        }
+
+        basic_stringref& assign(basic_stringref&& other) noexcept(allocator_is_always_equal)
+        {
+            return __int_move_assign(other, 0, npos, false);
+        }
+
+        basic_stringref& assign(basic_stringref&& other, std::true_type)
+        {
+            return __int_move_assign(other, 0, npos, true);
+        }
+
+        basic_stringref& assign(basic_stringref&& other, size_type offset, size_type length)
+        {
+            return __int_move_assign(other, offset, length, false);
+        }
+
+        basic_stringref& assign(basic_stringref&& other, size_type offset, size_type length, std::true_type)
+        {
+            return __int_move_assign(other, offset, length, true);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>&& other)
+        {
+            return __int_move_assign(other, 0, npos, false);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>&& other, std::true_type)
+        {
+            return __int_move_assign(other, 0, npos, true);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>&& other, size_type offset,
+                                size_type length)
+        {
+            return __int_move_assign(other, offset, length, false);
+        }
+
+        template<typename _OTraits>
+        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc, _RefCount>&& other, size_type offset,
+                                size_type length, std::true_type)
+        {
+            return __int_move_assign(other, offset, length, true);
+        }
+
+        basic_stringref& operator = (const basic_stringref& other)
+        {
+            return __int_copy_assign(other, 0, npos, false);
+        }
+
+        basic_stringref& operator = (basic_stringref&& other) noexcept(allocator_is_always_equal)
+        {
+            return __int_move_assign(other, 0, npos, false);
+        }
+
+        // Allocators are swapped only if they propagate on swap, otherwise they must be equal.
+        void swap(basic_stringref& other) noexcept
+        {
+            __int_swap_alloc(other, typename _Alloc_traits::propagate_on_container_swap());
+            std::swap(rep_.words_, other.rep_.words_);
+        }
+
+        bool empty() const
+        {
+            return (0 == size());
+        }
+
+        size_type size() const
+        {
+            switch (__int_tag()) {
+            case _Tag_Ref:
+                return static_cast<size_type>(rep_.words_.len_);
+            case _Tag_Inline:
+                return (__int_tag_byte() & ~_Tag_Mask);
+            default:
+                return __int_length();
+            }
+        }
+
+        const_pointer data() const
+        {
+            unsigned char tag = __int_tag();
+            switch (tag) {
+            case _Tag_Ref:
+                return rep_.words_.ptr_;
+            case _Tag_Inline:
+                return rep_.buf_;
+            default:
+                return __int_block_data(__int_data(), tag) + __int_offset();
+            }
+        }
+
+        // Returns null-terminated string without copying, or null, if the string is not terminated in place.
+        // Detached strings are usually terminated: inline ones, which do not fill the buffer, and the ones, which
+        // reach the end of their data block. Like other const members, it may be called concurrently.
+        const_pointer terminated_data() const
+        {
+            static const value_type empty = value_type();
+            const_pointer data = this->data();
+            size_type len = size();
+            switch (__int_tag()) {
+            case _Tag_Ref:
+                return (0 == len) ? &empty : nullptr;
+            case _Tag_Inline:
+                return (len < _Inline_Capacity) ? data : nullptr;
+            default:
+                // Data block always has a character or the terminator after the end of the string.
+                return _Traits::eq(data[len], value_type()) ? data : nullptr;
+            }
+        }
+
+        // Returns null-terminated string, never null. If it is not terminated in place, the string is replaced with
+        // its terminated detached copy. This modifies the stringref, but not the data shared with other stringrefs,
+        // so a stringref, which is read concurrently, must use terminated_data() or c_str(buffer) instead.
+        const_pointer c_str()
+        {
+            const_pointer result = terminated_data();
+            if (nullptr == result) {
+                // Full inline buffer has no space for the terminator.
+                basic_stringref tmp(rep_.__int_alloc());
+                if (size() < _Inline_Capacity) {
+                    tmp.__int_set_inline(data(), size());
+                } else {
+                    tmp.__int_allocate(data(), size());
+                }
+                __int_clear();
+                __int_steal(tmp);
+                result = data();
+            }
+            return result;
+        }
+
+        // Returns null-terminated string, copied into the buffer, if it is not terminated in place.
+        template<typename _OTraits, typename _OAlloc>
+        const_pointer c_str(std::basic_string<value_type, _OTraits, _OAlloc>& buffer) const
+        {
+            const_pointer result = terminated_data();
+            if (nullptr == result) {
+                buffer.assign(data(), size());
+                result = buffer.c_str();
+            }
+            return result;
+        }
+
+        basic_stringref& detach()
+        {
+            if (!is_detached()) {
+                __int_construct(rep_.words_.ptr_, size(), 0, npos, true);
+            }
+            return *this;
+        }
+
+        bool is_detached() const
+        {
+            return (_Tag_Ref != __int_tag());
+        }
+
+        // Enables content deduplication of detached copies in the whole process for all stringref types with this
+        // character type, allocator and reference counter, whatever their traits: detach(), constructors and
+        // assignments with std::true_type share the data block of an equal detached string instead of allocating
+        // a new one. Blocks allocated before enabling are not deduplicated.
+        static void set_dedup(bool enabled)
+        {
+            static_assert(_Dedup_Supported, "Deduplication requires atomic_refcount and an always equal allocator.");
+            __int_dedup().enabled_.store(enabled, std::memory_order_relaxed);
+        }
+
+        static bool dedup_enabled()
+        {
+            return _Dedup_Supported && __int_dedup().enabled_.load(std::memory_order_relaxed);
+        }
+
+        static stringref_dedup_stats dedup_stats()
+        {
+            const _Dedup& dedup = __int_dedup();
+            return stringref_dedup_stats{dedup.blocks_.load(std::memory_order_relaxed),
+                                         dedup.hits_.load(std::memory_order_relaxed),
+                                         dedup.bytes_saved_.load(std::memory_order_relaxed)};
+        }
+
+        // Hash of the characters, consistent with the equality of the traits. Traits other than
+        // std::char_traits must provide __int_fold(), which maps equal characters to the same value.
+        std::size_t hash() const
+        {
+            return __int_hash(std::is_same<_Traits, std::char_traits<value_type> >());
+        }
+
+        size_type find(value_type c, size_type pos = 0) const
+        {
+            size_type len = size();
+            if (pos >= len) {
+                return npos;
+            }
+            return __int_found(_Search::find(data() + pos, len - pos, c), pos);
+        }
+
+        size_type rfind(value_type c, size_type pos = npos) const
+        {
+            size_type len = size();
+            if (0 == len) {
+                return npos;
+            }
+            return __int_found(_Search::rfind(data(), std::min(pos, len - 1) + 1, c), 0);
+        }
+
+        inline size_type find(const_pointer string, size_type pos = 0) const
+        {
+            return find(string, pos, __int_strlen(string));
+        }
+
+        size_type find(const_pointer string, size_type pos, size_type count) const
+        {
+            size_type len = size();
+            if (pos > len) {
+                return npos;
+            }
+            return __int_found(_Search::find(data() + pos, len - pos, string, count), pos);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline size_type find(const std::basic_string<value_type, _OTraits, _OAlloc>& string, size_type pos = 0) const
+        {
+            return find(string.data(), pos, string.size());
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline size_type find(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string,
+                              size_type pos = 0) const
+        {
+            return find(string.data(), pos, string.size());
+        }
+
+        template<typename _OTraits>
+        inline size_type find(const basic_stringref_literal<value_type, _OTraits>& string, size_type pos = 0) const
+        {
+            return find(string.data(), pos, string.size());
+        }
+
+        inline bool contains(value_type c) const
+        {
+            return (npos != find(c));
+        }
+
+        inline bool contains(const_pointer string) const
+        {
+            return (npos != find(string));
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline bool contains(const std::basic_string<value_type, _OTraits, _OAlloc>& string) const
+        {
+            return (npos != find(string));
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline bool contains(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string) const
+        {
+            return (npos != find(string));
+        }
+
+        template<typename _OTraits>
+        inline bool contains(const basic_stringref_literal<value_type, _OTraits>& string) const
+        {
+            return (npos != find(string));
+        }
+
+        inline bool starts_with(value_type c) const
+        {
+            return (!empty()) && _Traits::eq(data()[0], c);
+        }
+
+        inline bool starts_with(const_pointer string) const
+        {
+            return starts_with(string, __int_strlen(string));
+        }
+
+        bool starts_with(const_pointer string, size_type count) const
+        {
+            return (count <= size()) && _Search::equal(data(), string, count);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline bool starts_with(const std::basic_string<value_type, _OTraits, _OAlloc>& string) const
+        {
+            return starts_with(string.data(), string.size());
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline bool starts_with(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string) const
+        {
+            return starts_with(string.data(), string.size());
+        }
+
+        // Length of the literal is known at compile time, so short prefixes are compared without loops.
+        template<typename _OTraits>
+        inline bool starts_with(const basic_stringref_literal<value_type, _OTraits>& string) const
+        {
+            return starts_with(string.data(), string.size());
+        }
+
+        inline bool ends_with(value_type c) const
+        {
+            return (!empty()) && _Traits::eq(data()[size() - 1], c);
+        }
+
+        inline bool ends_with(const_pointer string) const
         {
-            __int_construct(string.data(), string.size(), offset, length, string.is_detached());
+            return ends_with(string, __int_strlen(string));
         }
 
-        basic_stringref(basic_stringref&& other) :
-            a_(other.a_)
+        bool ends_with(const_pointer string, size_type count) const
         {
-            __int_move_construct(other, 0, other.len_);
+            size_type len = size();
+            return (count <= len) && _Search::equal(data() + (len - count), string, count);
         }
 
-        basic_stringref(basic_stringref&& other, size_type offset, size_type length) :
-            a_(other.a_)
+        template<typename _OTraits, typename _OAlloc>
+        inline bool ends_with(const std::basic_string<value_type, _OTraits, _OAlloc>& string) const
         {
-            __int_move_construct(other, offset, length);
+            return ends_with(string.data(), string.size());
         }
 
-        template<typename _OTraits>
-        explicit basic_stringref(basic_stringref<value_type, _OTraits, _Alloc>&& other) :
-            a_(other.a_)
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline bool ends_with(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string) const
         {
-            __int_move_construct(other, 0, other.len_);
+            return ends_with(string.data(), string.size());
         }
 
         template<typename _OTraits>
-        basic_stringref(basic_stringref<value_type, _OTraits, _Alloc>&& other, size_type offset, size_type length) :
-            a_(other.a_)
+        inline bool ends_with(const basic_stringref_literal<value_type, _OTraits>& string) const
         {
-            __int_move_construct(other, offset, length);
+            return ends_with(string.data(), string.size());
         }
 
-        ~basic_stringref()
+        // Removes count characters from the beginning. Data block stays shared, unless the offset in the block
+        // becomes too large.
+        basic_stringref& remove_prefix(size_type count)
         {
-            __int_release_data(d_);
+            return __int_move_assign(*this, count, npos, false);
         }
 
-        inline basic_stringref& assign(const_pointer string)
+        basic_stringref& remove_suffix(size_type count)
         {
-            return __int_assign(string, __int_strlen(string), 0, npos, false);
+            size_type len = size();
+            return __int_move_assign(*this, 0, len - std::min(count, len), false);
         }
 
-        inline basic_stringref& assign(const_pointer string, std::true_type)
+        // Returns the rest of the string after the prefix, which shares data with this stringref. Returns the
+        // whole string, if it does not start with the prefix.
+        inline basic_stringref strip_prefix(value_type c) const
         {
-            return __int_assign(string, __int_strlen(string), 0, npos, true);
+            return starts_with(c) ? basic_stringref(*this, 1, npos) : *this;
         }
 
-        inline basic_stringref& assign(const_pointer string, size_type size)
+        inline basic_stringref strip_prefix(const_pointer string) const
         {
-            return __int_assign(string, size, 0, npos, false);
+            return strip_prefix(string, __int_strlen(string));
         }
 
-        inline basic_stringref& assign(const_pointer string, size_type size, std::true_type)
+        basic_stringref strip_prefix(const_pointer string, size_type count) const
         {
-            return __int_assign(string, size, 0, npos, true);
+            return starts_with(string, count) ? basic_stringref(*this, count, npos) : *this;
         }
 
-        inline basic_stringref& assign(const_pointer string, size_type offset, size_type length)
+        template<typename _OTraits, typename _OAlloc>
+        inline basic_stringref strip_prefix(const std::basic_string<value_type, _OTraits, _OAlloc>& string) const
         {
-            return __int_assign(string, __int_strlen(string), offset, length, false);
+            return strip_prefix(string.data(), string.size());
         }
 
-        inline basic_stringref& assign(const_pointer string, size_type offset, size_type length, std::true_type)
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        basic_stringref strip_prefix(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string) const
         {
-            return __int_assign(string, __int_strlen(string), offset, length, true);
+            return strip_prefix(string.data(), string.size());
         }
 
-        inline basic_stringref& assign(const_pointer string, size_type size, size_type offset, size_type length)
+        template<typename _OTraits>
+        inline basic_stringref strip_prefix(const basic_stringref_literal<value_type, _OTraits>& string) const
         {
-            return __int_assign(string, size, offset, length, false);
+            return strip_prefix(string.data(), string.size());
         }
 
-        inline basic_stringref& assign(const_pointer string, size_type size, size_type offset, size_type length,
-                                       std::true_type)
+        inline size_type find_first_of(value_type c, size_type pos = 0) const
         {
-            return __int_assign(string, size, offset, length, true);
+            return find_first_of(&c, pos, 1);
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string)
+        inline size_type find_first_of(const_pointer set, size_type pos = 0) const
         {
-            return __int_assign(string.data(), string.size(), 0, npos, false);
+            return find_first_of(set, pos, __int_strlen(set));
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string, std::true_type)
+        size_type find_first_of(const_pointer set, size_type pos, size_type count) const
         {
-            return __int_assign(string.data(), string.size(), 0, npos, true);
+            size_type len = size();
+            if (pos >= len) {
+                return npos;
+            }
+            return __int_found(_Search::find_first_of(data() + pos, len - pos, set, count), pos);
         }
 
         template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
-                                       size_type offset, size_type length)
+        inline size_type find_first_of(const std::basic_string<value_type, _OTraits, _OAlloc>& set,
+                                       size_type pos = 0) const
         {
-            return __int_assign(string.data(), string.size(), offset, length, false);
+            return find_first_of(set.data(), pos, set.size());
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const std::basic_string<value_type, _OTraits, _OAlloc>& string,
-                                       size_type offset, size_type length, std::true_type)
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline size_type find_first_of(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& set,
+                             size_type pos = 0) const
         {
-            return __int_assign(string.data(), string.size(), offset, length, true);
+            return find_first_of(set.data(), pos, set.size());
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(std::basic_string<value_type, _OTraits, _OAlloc>&& string)
+        template<typename _OTraits>
+        inline size_type find_first_of(const basic_stringref_literal<value_type, _OTraits>& set,
+                                       size_type pos = 0) const
         {
-            return __int_assign(string.data(), string.size(), 0, npos, true);
+            return find_first_of(set.data(), pos, set.size());
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(std::basic_string<value_type, _OTraits, _OAlloc>&& string, size_type offset,
-                                size_type length)
+        inline size_type find_last_of(value_type c, size_type pos = npos) const
         {
-            return __int_assign(string.data(), string.size(), offset, length, true);
+            return find_last_of(&c, pos, 1);
         }
 
-        basic_stringref& assign(const basic_stringref& other)
+        inline size_type find_last_of(const_pointer set, size_type pos = npos) const
         {
-            return __int_copy_assign(other, 0, npos, false);
+            return find_last_of(set, pos, __int_strlen(set));
         }
 
-        basic_stringref& assign(const basic_stringref& other, std::true_type)
+        size_type find_last_of(const_pointer set, size_type pos, size_type count) const
         {
-            return __int_copy_assign(other, 0, npos, true);
+            size_type len = size();
+            if (0 == len) {
+                return npos;
+            }
+            return __int_found(_Search::find_last_of(data(), std::min(pos, len - 1) + 1, set, count), 0);
         }
 
-        basic_stringref& assign(const basic_stringref& other, size_type offset, size_type length)
+        template<typename _OTraits, typename _OAlloc>
+        inline size_type find_last_of(const std::basic_string<value_type, _OTraits, _OAlloc>& set,
+                                      size_type pos = npos) const
         {
-            return __int_copy_assign(other, offset, length, false);
+            return find_last_of(set.data(), pos, set.size());
         }
 
-        basic_stringref& assign(const basic_stringref& other, size_type offset, size_type length, std::true_type)
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline size_type find_last_of(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& set,
+                             size_type pos = npos) const
         {
-            return __int_copy_assign(other, offset, length, true);
+            return find_last_of(set.data(), pos, set.size());
         }
 
         template<typename _OTraits>
-        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc>& other);
-        template<typename _OTraits>
-        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc>& other, std::true_type);
-        template<typename _OTraits>
-        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc>& other, size_type offset,
-                                size_type length);
-        template<typename _OTraits>
-        basic_stringref& assign(const basic_stringref<value_type, _OTraits, _Alloc>& other, size_type offset,
-                                size_type length, std::true_type);
+        inline size_type find_last_of(const basic_stringref_literal<value_type, _OTraits>& set,
+                                      size_type pos = npos) const
+        {
+            return find_last_of(set.data(), pos, set.size());
+        }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc>& other)
+        inline size_type find_first_not_of(value_type c, size_type pos = 0) const
         {
-            return __int_assign(other.data(), other.size(), 0, npos, other.is_detached());
+            return find_first_not_of(&c, pos, 1);
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc>& other, std::true_type)
+        inline size_type find_first_not_of(const_pointer set, size_type pos = 0) const
         {
-            return __int_assign(other.data(), other.size(), 0, npos, true);
+            return find_first_not_of(set, pos, __int_strlen(set));
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc>& other, size_type offset,
-                                       size_type length)
+        size_type find_first_not_of(const_pointer set, size_type pos, size_type count) const
         {
-            return __int_assign(other.data(), other.size(), offset, length, other.is_detached());
+            size_type len = size();
+            if (pos >= len) {
+                return npos;
+            }
+            return __int_found(_Search::find_first_not_of(data() + pos, len - pos, set, count), pos);
         }
 
         template<typename _OTraits, typename _OAlloc>
-        inline basic_stringref& assign(const basic_stringref<value_type, _OTraits, _OAlloc>& other, size_type offset,
-                                       size_type length, std::true_type)
+        inline size_type find_first_not_of(const std::basic_string<value_type, _OTraits, _OAlloc>& set,
+                                           size_type pos = 0) const
         {
-            return __int_assign(other.data(), other.size(), offset, length, true);
+            return find_first_not_of(set.data(), pos, set.size());
         }
 
-        basic_stringref& assign(basic_stringref&& other);
-        basic_stringref& assign(basic_stringref&& other, std::true_type);
-        basic_stringref& assign(basic_stringref&& other, size_type offset, size_type length);
-        basic_stringref& assign(basic_stringref&& other, size_type offset, size_type length, std::true_type);
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline size_type find_first_not_of(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& set,
+                             size_type pos = 0) const
+        {
+            return find_first_not_of(set.data(), pos, set.size());
+        }
 
         template<typename _OTraits>
-        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc>&& other);
-        template<typename _OTraits>
-        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc>&& other, std::true_type);
-        template<typename _OTraits>
-        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc>&& other, size_type offset,
-                                size_type length);
-        template<typename _OTraits>
-        basic_stringref& assign(basic_stringref<value_type, _OTraits, _Alloc>&& other, size_type offset,
-                                size_type length, std::true_type);
-
-        bool empty() const
+        inline size_type find_first_not_of(const basic_stringref_literal<value_type, _OTraits>& set,
+                                           size_type pos = 0) const
         {
-            return (0 == len_);
+            return find_first_not_of(set.data(), pos, set.size());
         }
 
-        size_type size() const
+        inline size_type find_last_not_of(value_type c, size_type pos = npos) const
         {
-            return len_;
+            return find_last_not_of(&c, pos, 1);
         }
 
-        const_pointer data() const
+        inline size_type find_last_not_of(const_pointer set, size_type pos = npos) const
         {
-            return ptr_;
+            return find_last_not_of(set, pos, __int_strlen(set));
         }
 
-        basic_stringref& detach()
+        size_type find_last_not_of(const_pointer set, size_type pos, size_type count) const
         {
-            if (nullptr == d_) {
-                __int_construct(ptr_, len_, 0, len_, true);
+            size_type len = size();
+            if (0 == len) {
+                return npos;
             }
-            return *this;
+            return __int_found(_Search::find_last_not_of(data(), std::min(pos, len - 1) + 1, set, count), 0);
         }
 
-        bool is_detached() const
+        template<typename _OTraits, typename _OAlloc>
+        inline size_type find_last_not_of(const std::basic_string<value_type, _OTraits, _OAlloc>& set,
+                                          size_type pos = npos) const
+        {
+            return find_last_not_of(set.data(), pos, set.size());
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline size_type find_last_not_of(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& set,
+                             size_type pos = npos) const
+        {
+            return find_last_not_of(set.data(), pos, set.size());
+        }
+
+        template<typename _OTraits>
+        inline size_type find_last_not_of(const basic_stringref_literal<value_type, _OTraits>& set,
+                                          size_type pos = npos) const
         {
-            return (nullptr != d_);
+            return find_last_not_of(set.data(), pos, set.size());
         }
 
         inline int compare(const_pointer other) const
         {
-            return __int_compare(ptr_, len_, other, __int_strlen(other));
+            return __int_compare(data(), size(), other, __int_strlen(other));
         }
 
         inline int compare(const_pointer other, size_type other_size) const
         {
-            return __int_compare(ptr_, len_, other, other_size);
+            return __int_compare(data(), size(), other, other_size);
         }
 
         template<typename _OTraits, typename _OAlloc>
         inline int compare(const std::basic_string<value_type, _OTraits, _OAlloc>& string) const
         {
-            return __int_compare(ptr_, len_, string.data(), string.size());
+            return __int_compare(data(), size(), string.data(), string.size());
+        }
+
+        template<typename _OTraits>
+        inline int compare(const basic_stringref_literal<value_type, _OTraits>& literal) const
+        {
+            return __int_compare(data(), size(), literal.data(), literal.size());
         }
 
         inline int compare(const basic_stringref& other) const
@@ -563,69 +1919,95 @@ namespace mg {
             if (this == &other) {
                 return 0;
             }
-            return __int_compare(ptr_, len_, other.ptr_, other.len_);
+            return __int_compare(data(), size(), other.data(), other.size());
         }
 
-        template<typename _OTraits, typename _OAlloc>
-        inline int compare(const basic_stringref<value_type, _OTraits, _OAlloc>& other) const
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline int compare(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& other) const
         {
-            return __int_compare(ptr_, len_, other.data(), other.size());
+            return __int_compare(data(), size(), other.data(), other.size());
         }
 
         template<typename T>
-        inline bool operator < (T other) const
+        inline bool operator < (const T& other) const
         {
             return (0 > compare(other));
         }
 
         template<typename T>
-        inline bool operator <= (T other) const
+        inline bool operator <= (const T& other) const
         {
             return (0 >= compare(other));
         }
 
         template<typename T>
-        inline bool operator > (T other) const
+        inline bool operator > (const T& other) const
         {
             return (0 < compare(other));
         }
 
         template<typename T>
-        inline bool operator >= (T other) const
+        inline bool operator >= (const T& other) const
         {
             return (0 <= compare(other));
         }
 
         template<typename T>
-        inline bool operator == (T other) const
+        inline bool operator == (const T& other) const
         {
             return (0 == compare(other));
         }
 
         template<typename T>
-        inline bool operator != (T other) const
+        inline bool operator != (const T& other) const
         {
             return (0 != compare(other));
         }
 
+        // Strings of different lengths are not equal, so their characters are not loaded.
+        inline bool operator == (const basic_stringref& other) const
+        {
+            const size_type len = size();
+            return (len == other.size()) && ((this == &other) || (0 == _Traits::compare(data(), other.data(), len)));
+        }
+
+        inline bool operator != (const basic_stringref& other) const
+        {
+            return !(*this == other);
+        }
+
     private:
-        _Char_alloc_type a_;
-        _Data *d_ = nullptr;
-        const_pointer ptr_ = nullptr;
-        size_type len_ = 0;
+        _Rep rep_;
 
-        template<typename C, typename T, typename A>
+        template<typename C, typename T, typename A, typename R>
         friend class basic_stringref;
     };
 
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const typename basic_stringref<_CharT, _Traits, _Alloc, _RefCount>::size_type
+        basic_stringref<_CharT, _Traits, _Alloc, _RefCount>::npos;
+
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const bool basic_stringref<_CharT, _Traits, _Alloc, _RefCount>::allocator_is_always_equal;
+
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const std::true_type basic_stringref<_CharT, _Traits, _Alloc, _RefCount>::detached;
+
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    inline void swap(basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s1,
+                     basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s2) noexcept
+    {
+        s1.swap(s2);
+    }
+
     template <typename T>
     struct is_stringref
     {
         static constexpr bool value = false;
     };
 
-    template<typename _CharT, typename _Traits, typename _Alloc>
-    struct is_stringref<basic_stringref<_CharT, _Traits, _Alloc> >
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    struct is_stringref<basic_stringref<_CharT, _Traits, _Alloc, _RefCount> >
     {
         static constexpr bool value = true;
     };
@@ -634,6 +2016,39 @@ namespace mg {
     typedef basic_stringref<char16_t> ustringref;
     typedef basic_stringref<wchar_t> wstringref;
 
+    static_assert((8 != sizeof(void*)) || (16 == sizeof(stringref)), "stringref must be two words long.");
+    // The length word is 64-bit long on 32-bit targets too: stringref takes 12 bytes, or 16 bytes, if 64-bit
+    // integers are 8-byte aligned in structures.
+    static_assert((4 != sizeof(void*)) || (sizeof(stringref) == sizeof(std::pair<const char*, std::uint64_t>)),
+                  "stringref must be a pointer and a 64-bit word long.");
+
+    typedef basic_stringref_literal<char> stringref_literal;
+    typedef basic_stringref_literal<char16_t> ustringref_literal;
+    typedef basic_stringref_literal<wchar_t> wstringref_literal;
+
+    inline namespace literals {
+        constexpr stringref_literal operator "" _sr(const char* string, std::size_t size)
+        {
+            return stringref_literal(string, size);
+        }
+
+        constexpr ustringref_literal operator "" _sr(const char16_t* string, std::size_t size)
+        {
+            return ustringref_literal(string, size);
+        }
+
+        constexpr wstringref_literal operator "" _sr(const wchar_t* string, std::size_t size)
+        {
+            return wstringref_literal(string, size);
+        }
+    }
+
+    typedef basic_stringref<char, std::char_traits<char>, std::allocator<char>, single_thread_refcount> st_stringref;
+    typedef basic_stringref<char16_t, std::char_traits<char16_t>, std::allocator<char16_t>,
+                            single_thread_refcount> st_ustringref;
+    typedef basic_stringref<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t>,
+                            single_thread_refcount> st_wstringref;
+
     template<typename _CharT>
     struct ci_char_traits;
 
@@ -643,27 +2058,31 @@ namespace mg {
         static bool
         eq(const char_type& __c1, const char_type& __c2)
         {
-            return std::toupper(static_cast<unsigned char>(__c1)) == std::toupper(static_cast<unsigned char>(__c2));
+            return __int_toupper(__c1) == __int_toupper(__c2);
         }
 
+        // End of file is equal only to itself, characters are folded as in eq().
         static bool
         eq_int_type(int_type __c1, int_type __c2)
         {
-            return ::toupper(__c1) == ::toupper(__c2);
+            if ((eof() == __c1) || (eof() == __c2)) {
+                return __c1 == __c2;
+            }
+            return __int_toupper(to_char_type(__c1)) == __int_toupper(to_char_type(__c2));
         }
 
         static bool
         lt(const char_type& __c1, const char_type& __c2)
         {
-            return std::toupper(static_cast<unsigned char>(__c1)) < std::toupper(static_cast<unsigned char>(__c2));
+            return __int_toupper(__c1) < __int_toupper(__c2);
         }
 
         static int
         compare(const char_type* __s1, const char_type* __s2, size_t __n)
         {
-            while(__n--) {
-                auto __c1 = std::toupper(static_cast<unsigned char>(*__s1));
-                auto __c2 = std::toupper(static_cast<unsigned char>(*__s2));
+            for (size_t __i = __int_ascii_ci_prefix(__s1, __s2, __n); __i < __n; ++__i) {
+                int __c1 = __int_toupper(__s1[__i]);
+                int __c2 = __int_toupper(__s2[__i]);
                 if (__c1 < __c2) {
                     return (-1);
                 }
@@ -677,43 +2096,62 @@ namespace mg {
         static const char_type*
         find( const char_type* __p, std::size_t __n, const char_type& __c)
         {
-            auto __cu = std::toupper(static_cast<unsigned char>(__c));
-            for (; __n; --__n, ++__p) {
-                if (std::toupper(static_cast<unsigned char>(*__p)) == __cu) {
-                    return __p;
-                }
+            char_type __u = static_cast<char_type>(__int_toupper(__c));
+            char_type __l = ((__u >= 'A') && (__u <= 'Z')) ? static_cast<char_type>(__u + ('a' - 'A')) : __u;
+            return __int_ci_find<ci_char_traits>(__p, __n, __c, __u, __l);
+        }
+
+        static std::uint32_t
+        __int_fold(char_type __c)
+        {
+            return static_cast<std::uint32_t>(__int_toupper(__c));
+        }
+
+        // ASCII letters are converted without the locale, as in the "C" locale.
+        static int
+        __int_toupper(char_type __c)
+        {
+            unsigned char __u = static_cast<unsigned char>(__c);
+            if (__u >= 0x80) {
+                return std::toupper(__u);
             }
-            return nullptr;
+            return ((__u >= 'a') && (__u <= 'z')) ? (__u - ('a' - 'A')) : __u;
         }
     };
 
-    template<>
-    struct ci_char_traits<wchar_t> : public std::char_traits<wchar_t>
+    // Case-insensitive traits of UTF-16 and UTF-32 code units. Characters are compared by the simple case folding
+    // of the Basic Multilingual Plane, which is a table lookup and does not depend on the locale.
+    template<typename _CharT>
+    struct __int_unicode_ci_traits : public std::char_traits<_CharT>
     {
+        typedef typename std::char_traits<_CharT>::char_type char_type;
+        typedef typename std::char_traits<_CharT>::int_type int_type;
+
         static bool
         eq(const char_type& __c1, const char_type& __c2)
         {
-            return std::towupper(__c1) == std::towupper(__c2);
+            return __int_fold(__c1) == __int_fold(__c2);
         }
 
         static bool
         eq_int_type(int_type __c1, int_type __c2)
         {
-            return ::towupper(__c1) == ::towupper(__c2);
+            return (__int_casefold(static_cast<std::uint32_t>(__c1)) ==
+                    __int_casefold(static_cast<std::uint32_t>(__c2)));
         }
 
         static bool
         lt(const char_type& __c1, const char_type& __c2)
         {
-            return std::towupper(__c1) < std::towupper(__c2);
+            return __int_fold(__c1) < __int_fold(__c2);
         }
 
         static int
         compare(const char_type* __s1, const char_type* __s2, size_t __n)
         {
-            while(__n--) {
-                auto __c1 = std::towupper(*__s1);
-                auto __c2 = std::towupper(*__s2);
+            for (; __n; --__n, ++__s1, ++__s2) {
+                std::uint32_t __c1 = __int_fold(*__s1);
+                std::uint32_t __c2 = __int_fold(*__s2);
                 if (__c1 < __c2) {
                     return (-1);
                 }
@@ -727,59 +2165,385 @@ namespace mg {
         static const char_type*
         find( const char_type* __p, std::size_t __n, const char_type& __c)
         {
-            auto __cu = std::towupper(__c);
-            for (; __n; --__n, ++__p) {
-                if (std::towupper(*__p) == __cu) {
-                    return __p;
+            // Folded ASCII letters are lowercase, the other ASCII variant is uppercase.
+            char_type __l = static_cast<char_type>(__int_fold(__c));
+            char_type __u = ((__l >= 'a') && (__l <= 'z')) ? static_cast<char_type>(__l - ('a' - 'A')) : __l;
+            return __int_ci_find<__int_unicode_ci_traits>(__p, __n, __c, __u, __l);
+        }
+
+        static std::uint32_t
+        __int_fold(char_type __c)
+        {
+            return __int_casefold(static_cast<std::uint32_t>(__c));
+        }
+    };
+
+    template<>
+    struct ci_char_traits<wchar_t> : public __int_unicode_ci_traits<wchar_t>
+    {};
+
+    template<>
+    struct ci_char_traits<char16_t> : public __int_unicode_ci_traits<char16_t>
+    {};
+
+    template<>
+    struct ci_char_traits<char32_t> : public __int_unicode_ci_traits<char32_t>
+    {};
+
+    // Case-insensitive traits for ASCII protocols: HTTP headers, SMTP commands, configuration keys. Only ASCII
+    // letters are folded, without the locale and without branches. Other characters are compared as is.
+    template<typename _CharT>
+    struct ascii_ci_char_traits : public std::char_traits<_CharT>
+    {
+        typedef typename std::char_traits<_CharT>::char_type char_type;
+        typedef typename std::char_traits<_CharT>::int_type int_type;
+
+        static constexpr bool
+        eq(const char_type& __c1, const char_type& __c2)
+        {
+            return __int_fold(__c1) == __int_fold(__c2);
+        }
+
+        static constexpr bool
+        eq_int_type(int_type __c1, int_type __c2)
+        {
+            return (__int_fold_code(static_cast<std::uint32_t>(__c1)) ==
+                    __int_fold_code(static_cast<std::uint32_t>(__c2)));
+        }
+
+        static constexpr bool
+        lt(const char_type& __c1, const char_type& __c2)
+        {
+            return __int_fold(__c1) < __int_fold(__c2);
+        }
+
+        // Constant evaluation uses the recursive comparison, run time comparison is vectorized.
+        static constexpr int
+        compare(const char_type* __s1, const char_type* __s2, std::size_t __n)
+        {
+#ifdef MGSTRINGREF_HAS_IS_CONSTANT_EVALUATED
+            return __builtin_is_constant_evaluated() ? __int_compare_const(__s1, __s2, __n)
+                                                     : __int_compare(__s1, __s2, __n);
+#else
+            return __int_compare_const(__s1, __s2, __n);
+#endif
+        }
+
+        static const char_type*
+        find( const char_type* __p, std::size_t __n, const char_type& __c)
+        {
+            char_type __u = static_cast<char_type>(__int_fold(__c));
+            char_type __l = ((__u >= 'A') && (__u <= 'Z')) ? static_cast<char_type>(__u + ('a' - 'A')) : __u;
+            return __int_ci_find<ascii_ci_char_traits>(__p, __n, __c, __u, __l);
+        }
+
+        // Lowercase ASCII letters are converted to uppercase, as ci_char_traits<char> does.
+        static constexpr std::uint32_t
+        __int_fold_code(std::uint32_t __u)
+        {
+            return __u - (static_cast<std::uint32_t>((__u - 'a') < 26u) << 5);
+        }
+
+        static constexpr std::uint32_t
+        __int_fold(char_type __c)
+        {
+            typedef typename std::make_unsigned<char_type>::type _Unsigned;
+            return __int_fold_code(static_cast<std::uint32_t>(static_cast<_Unsigned>(__c)));
+        }
+
+        static constexpr int
+        __int_compare_const(const char_type* __s1, const char_type* __s2, std::size_t __n)
+        {
+            return (0 == __n) ? 0
+                : lt(*__s1, *__s2) ? (-1)
+                : lt(*__s2, *__s1) ? 1
+                : __int_compare_const(__s1 + 1, __s2 + 1, __n - 1);
+        }
+
+        static int
+        __int_compare(const char_type* __s1, const char_type* __s2, std::size_t __n)
+        {
+            for (std::size_t __i = __int_prefix(__s1, __s2, __n); __i < __n; ++__i) {
+                std::uint32_t __c1 = __int_fold(__s1[__i]);
+                std::uint32_t __c2 = __int_fold(__s2[__i]);
+                if (__c1 != __c2) {
+                    return (__c1 < __c2) ? (-1) : 1;
                 }
             }
-            return nullptr;
+            return 0;
+        }
+
+        static std::size_t
+        __int_prefix(const char* __s1, const char* __s2, std::size_t __n)
+        {
+            return __int_ascii_ci_prefix(__s1, __s2, __n);
+        }
+
+        template<typename _OCharT>
+        static std::size_t
+        __int_prefix(const _OCharT*, const _OCharT*, std::size_t)
+        {
+            return 0;
         }
     };
 
     typedef basic_stringref<char, ci_char_traits<char> > cistringref;
+    typedef basic_stringref<char16_t, ci_char_traits<char16_t> > ciustringref;
     typedef basic_stringref<wchar_t, ci_char_traits<wchar_t> > ciwstringref;
+    typedef basic_stringref<char, ascii_ci_char_traits<char> > asciicistringref;
+
+    template<typename _Traits, typename = void>
+    struct __int_has_fold : public std::false_type
+    {};
+
+    template<typename _Traits>
+    struct __int_has_fold<_Traits, decltype(static_cast<void>(_Traits::__int_fold(typename _Traits::char_type())))> :
+        public std::true_type
+    {};
+
+    // Maps every byte to the first byte, which is equal to it according to the traits, so equal characters share
+    // the class. Folds of the traits are looked up directly, only other traits are compared pairwise.
+    template<typename _Traits>
+    void __int_byte_classes(unsigned char* rep, std::true_type)
+    {
+        typedef typename _Traits::char_type char_type;
+        int first[256];
+        std::fill(first, first + 256, -1);
+        for (unsigned c = 0; c < 256; ++c) {
+            rep[c] = static_cast<unsigned char>(c);
+            const std::uint32_t f = static_cast<std::uint32_t>(_Traits::__int_fold(static_cast<char_type>(c)));
+            if (f < 256) {
+                if (first[f] < 0) {
+                    first[f] = static_cast<int>(c);
+                }
+                rep[c] = static_cast<unsigned char>(first[f]);
+                continue;
+            }
+            for (unsigned c2 = 0; c2 < c; ++c2) {
+                if (f == static_cast<std::uint32_t>(_Traits::__int_fold(static_cast<char_type>(c2)))) {
+                    rep[c] = rep[c2];
+                    break;
+                }
+            }
+        }
+    }
+
+    template<typename _Traits>
+    void __int_byte_classes(unsigned char* rep, std::false_type)
+    {
+        typedef typename _Traits::char_type char_type;
+        for (unsigned c = 0; c < 256; ++c) {
+            rep[c] = static_cast<unsigned char>(c);
+            if (!std::is_same<_Traits, std::char_traits<char_type> >::value) {
+                for (unsigned c2 = 0; c2 < c; ++c2) {
+                    if (_Traits::eq(static_cast<char_type>(c), static_cast<char_type>(c2))) {
+                        rep[c] = rep[c2];
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    template<typename _Traits>
+    inline void __int_byte_classes(unsigned char* rep)
+    {
+        __int_byte_classes<_Traits>(rep, __int_has_fold<_Traits>());
+    }
+
+    // Searcher for repeated search of the same needle. Search tables are built once in the constructor.
+    // Single byte characters are searched with Horspool algorithm, which falls back to Two-Way, if too many
+    // candidates fail, so worst case time stays linear. Other characters are searched with Two-Way.
+    template<typename _CharT, typename _Traits = std::char_traits<_CharT>, typename _Alloc = std::allocator<_CharT>,
+             typename _RefCount = atomic_refcount>
+    class basic_stringref_searcher
+    {
+    public:
+        typedef basic_stringref<_CharT, _Traits, _Alloc, _RefCount> stringref_type;
+        typedef typename stringref_type::value_type value_type;
+        typedef typename stringref_type::size_type size_type;
+        typedef typename stringref_type::const_pointer const_pointer;
+
+        static constexpr const size_type npos = stringref_type::npos;
+
+        // Needle is detached, so the searcher does not depend on lifetime of the original string.
+        // Empty needle is never searched with Two-Way, it only needs a valid length.
+        explicit basic_stringref_searcher(const stringref_type& needle) :
+            needle_(needle), two_way_(needle.data(), std::max<size_type>(needle.size(), 1))
+        {
+            needle_.detach();
+            __int_init_shift(std::integral_constant<bool, (1 == sizeof(value_type))>());
+        }
+
+        const stringref_type& needle() const
+        {
+            return needle_;
+        }
+
+        size_type find(const_pointer haystack, size_type size, size_type pos = 0) const
+        {
+            if (pos > size) {
+                return npos;
+            }
+            std::size_t index = __int_find(haystack + pos, size - pos);
+            return (_Search::npos == index) ? npos : static_cast<size_type>(pos + index);
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline size_type find(const std::basic_string<value_type, _OTraits, _OAlloc>& haystack,
+                              size_type pos = 0) const
+        {
+            return find(haystack.data(), haystack.size(), pos);
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline size_type find(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& haystack,
+                              size_type pos = 0) const
+        {
+            return find(haystack.data(), haystack.size(), pos);
+        }
+
+        template<typename _String>
+        inline size_type operator () (const _String& haystack) const
+        {
+            return find(haystack);
+        }
+
+    private:
+        typedef __int_search<_Traits> _Search;
+
+        void __int_init_shift(std::false_type)
+        {}
+
+        void __int_init_shift(std::true_type)
+        {
+            const std::size_t m = needle_.size();
+            const_pointer x = needle_.data();
+            // Characters, which are equal according to the traits, must have the same shift.
+            unsigned char cls[256];
+            __int_byte_classes<_Traits>(cls);
+            std::size_t shift[256];
+            std::fill(shift, shift + 256, m);
+            for (std::size_t i = 0; i + 1 < m; ++i) {
+                shift[cls[static_cast<unsigned char>(x[i])]] = m - 1 - i;
+            }
+            for (unsigned c = 0; c < 256; ++c) {
+                shift_[c] = shift[cls[c]];
+            }
+        }
+
+        std::size_t __int_find(const_pointer s, std::size_t n) const
+        {
+            const std::size_t m = needle_.size();
+            const_pointer x = needle_.data();
+            if (0 == m) {
+                return 0;
+            }
+            if (m > n) {
+                return _Search::npos;
+            }
+            if (1 == m) {
+                return _Search::find(s, n, x[0]);
+            }
+            if (1 != sizeof(value_type)) {
+                return two_way_.find(s, n, x);
+            }
+
+            const std::size_t last = n - m;
+            std::size_t checked = 0;
+            for (std::size_t i = 0; i <= last; ) {
+                value_type c = s[i + m - 1];
+                if (_Traits::eq(c, x[m - 1])) {
+                    std::size_t k = m - 1;
+                    while ((0 != k) && _Traits::eq(s[i + k - 1], x[k - 1])) {
+                        --k;
+                    }
+                    if (0 == k) {
+                        return i;
+                    }
+                    checked += m - k;
+                    if (checked > 2 * i + 1024) {
+                        std::size_t pos = two_way_.find(s + i, n - i, x);
+                        return (_Search::npos == pos) ? _Search::npos : i + pos;
+                    }
+                }
+                i += shift_[static_cast<unsigned char>(c)];
+            }
+            return _Search::npos;
+        }
+
+        stringref_type needle_;
+        __int_two_way<_Traits> two_way_;
+        std::size_t shift_[(1 == sizeof(value_type)) ? 256 : 1];
+    };
+
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const typename basic_stringref_searcher<_CharT, _Traits, _Alloc, _RefCount>::size_type
+        basic_stringref_searcher<_CharT, _Traits, _Alloc, _RefCount>::npos;
+
+    typedef basic_stringref_searcher<char> stringref_searcher;
+    typedef basic_stringref_searcher<char16_t> ustringref_searcher;
+    typedef basic_stringref_searcher<wchar_t> wstringref_searcher;
+    typedef basic_stringref_searcher<char, ci_char_traits<char> > cistringref_searcher;
+    typedef basic_stringref_searcher<char16_t, ci_char_traits<char16_t> > ciustringref_searcher;
+    typedef basic_stringref_searcher<wchar_t, ci_char_traits<wchar_t> > ciwstringref_searcher;
+    typedef basic_stringref_searcher<char, ascii_ci_char_traits<char> > asciicistringref_searcher;
 }
 
-template<typename T, typename _CharT, typename _Traits, typename _Alloc>
+template<typename T, typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
 typename std::enable_if<!mg::is_stringref<T>::value, bool>::type
-inline operator < (T s1, const mg::basic_stringref<_CharT, _Traits, _Alloc>& s2)
+inline operator < (const T& s1, const mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s2)
 {
     return (0 < s2.compare(s1));
 }
 
-template<typename T, typename _CharT, typename _Traits, typename _Alloc>
+template<typename T, typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
 typename std::enable_if<!mg::is_stringref<T>::value, bool>::type
-inline operator <= (T s1, const mg::basic_stringref<_CharT, _Traits, _Alloc>& s2)
+inline operator <= (const T& s1, const mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s2)
 {
     return (0 <= s2.compare(s1));
 }
 
-template<typename T, typename _CharT, typename _Traits, typename _Alloc>
+template<typename T, typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
 typename std::enable_if<!mg::is_stringref<T>::value, bool>::type
-inline operator > (T s1, const mg::basic_stringref<_CharT, _Traits, _Alloc>& s2)
+inline operator > (const T& s1, const mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s2)
 {
     return (0 > s2.compare(s1));
 }
 
-template<typename T, typename _CharT, typename _Traits, typename _Alloc>
+template<typename T, typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
 typename std::enable_if<!mg::is_stringref<T>::value, bool>::type
-inline operator >= (T s1, const mg::basic_stringref<_CharT, _Traits, _Alloc>& s2)
+inline operator >= (const T& s1, const mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s2)
 {
     return (0 >= s2.compare(s1));
 }
 
-template<typename T, typename _CharT, typename _Traits, typename _Alloc>
+template<typename T, typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
 typename std::enable_if<!mg::is_stringref<T>::value, bool>::type
-inline operator == (T s1, const mg::basic_stringref<_CharT, _Traits, _Alloc>& s2)
+inline operator == (const T& s1, const mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s2)
 {
     return (0 == s2.compare(s1));
 }
 
-template<typename T, typename _CharT, typename _Traits, typename _Alloc>
+template<typename T, typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
 typename std::enable_if<!mg::is_stringref<T>::value, bool>::type
-inline operator != (T s1, const mg::basic_stringref<_CharT, _Traits, _Alloc>& s2)
+inline operator != (const T& s1, const mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount>& s2)
 {
     return (0 != s2.compare(s1));
 }
 
+namespace std {
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    struct hash<mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount> >
+    {
+        typedef mg::basic_stringref<_CharT, _Traits, _Alloc, _RefCount> argument_type;
+        typedef std::size_t result_type;
+
+        std::size_t operator()(const argument_type& s) const
+        {
+            return s.hash();
+        }
+    };
+}
+
+#endif // MGSTRINGREF_H
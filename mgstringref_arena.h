@@ -0,0 +1,185 @@
+#ifndef MGSTRINGREF_ARENA_H
+#define MGSTRINGREF_ARENA_H
+
+#include "mgstringref.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace mg {
+    // Bump allocator for stringrefs with the same lifetime. Memory is taken from large blocks and is never
+    // released separately: reset() releases all of it at once.
+    // All stringrefs using the arena must be destroyed before reset() or destruction of the arena.
+    // The arena is not thread-safe.
+    class stringref_arena
+    {
+    public:
+        static constexpr const std::size_t alignment = alignof(std::max_align_t);
+
+        explicit stringref_arena(std::size_t block_size = 64 * 1024) :
+            block_size_(block_size)
+        {}
+
+        stringref_arena(const stringref_arena&) = delete;
+        stringref_arena& operator =(const stringref_arena&) = delete;
+
+        ~stringref_arena()
+        {
+            __int_free(head_);
+        }
+
+        void* allocate(std::size_t size)
+        {
+            size = (size + alignment - 1) & ~(alignment - 1);
+            if (size > static_cast<std::size_t>(end_ - cur_)) {
+                if (size > (block_size_ / 4)) {
+                    // Large allocations get their own block, so the current block is not wasted.
+                    return __int_add_block(size, false);
+                }
+                cur_ = __int_add_block(block_size_, true);
+                end_ = cur_ + block_size_;
+            }
+            char* result = cur_;
+            cur_ += size;
+            allocated_ += size;
+            return result;
+        }
+
+        // Releases all memory, except one block, which is reused.
+        void reset()
+        {
+            _Block* keep = head_;
+            while (keep && !keep->reusable_) {
+                keep = keep->next_;
+            }
+            if (keep) {
+                _Block** link = &head_;
+                while (*link != keep) {
+                    link = &((*link)->next_);
+                }
+                *link = keep->next_;
+                keep->next_ = nullptr;
+            }
+            __int_free(head_);
+            head_ = keep;
+            cur_ = keep ? reinterpret_cast<char*>(keep) + _Block_Header_Size : nullptr;
+            end_ = keep ? cur_ + block_size_ : nullptr;
+            allocated_ = 0;
+        }
+
+        // Total size of allocations since construction or the last reset().
+        std::size_t allocated() const
+        {
+            return allocated_;
+        }
+
+        std::size_t block_count() const
+        {
+            std::size_t count = 0;
+            for (const _Block* block = head_; block; block = block->next_) {
+                count++;
+            }
+            return count;
+        }
+
+    private:
+        struct _Block {
+            _Block* next_;
+            bool reusable_;
+        };
+        static constexpr const std::size_t _Block_Header_Size = (sizeof(_Block) + alignment - 1) & ~(alignment - 1);
+
+        char* __int_add_block(std::size_t size, bool reusable)
+        {
+            void* memory = std::malloc(_Block_Header_Size + size);
+            if (nullptr == memory) {
+                throw std::bad_alloc();
+            }
+            _Block* block = static_cast<_Block*>(memory);
+            block->reusable_ = reusable;
+            if (reusable || (nullptr == head_)) {
+                block->next_ = head_;
+                head_ = block;
+            } else {
+                // Keep the current block at the head of the list.
+                block->next_ = head_->next_;
+                head_->next_ = block;
+            }
+            allocated_ += reusable ? 0 : size;
+            return static_cast<char*>(memory) + _Block_Header_Size;
+        }
+
+        static void __int_free(_Block* block)
+        {
+            while (block) {
+                _Block* next = block->next_;
+                std::free(block);
+                block = next;
+            }
+        }
+
+        std::size_t block_size_;
+        _Block* head_ = nullptr;
+        char* cur_ = nullptr;
+        char* end_ = nullptr;
+        std::size_t allocated_ = 0;
+    };
+
+    // Allocator, which takes memory from stringref_arena. Deallocation does nothing.
+    template <typename T>
+    class arena_allocator
+    {
+    public:
+        typedef T value_type;
+
+        explicit arena_allocator(stringref_arena& arena) noexcept :
+            arena_(&arena)
+        {}
+
+        template <typename U>
+        arena_allocator(const arena_allocator<U>& other) noexcept :
+            arena_(other.arena_)
+        {}
+
+        T* allocate(std::size_t n)
+        {
+            return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T*, std::size_t) noexcept
+        {}
+
+        stringref_arena& arena() const noexcept
+        {
+            return *arena_;
+        }
+
+        template <typename U>
+        bool operator ==(const arena_allocator<U>& other) const noexcept
+        {
+            return arena_ == other.arena_;
+        }
+
+        template <typename U>
+        bool operator !=(const arena_allocator<U>& other) const noexcept
+        {
+            return arena_ != other.arena_;
+        }
+
+    private:
+        stringref_arena* arena_;
+
+        template <typename U> friend class arena_allocator;
+    };
+
+    // Arena is not thread-safe, so stringrefs allocated in it use non-atomic reference counters.
+    typedef basic_stringref<char, std::char_traits<char>, arena_allocator<char>,
+                            single_thread_refcount> arena_stringref;
+    typedef basic_stringref<char16_t, std::char_traits<char16_t>, arena_allocator<char16_t>,
+                            single_thread_refcount> arena_ustringref;
+    typedef basic_stringref<wchar_t, std::char_traits<wchar_t>, arena_allocator<wchar_t>,
+                            single_thread_refcount> arena_wstringref;
+}
+
+#endif // MGSTRINGREF_ARENA_H
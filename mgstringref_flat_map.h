@@ -0,0 +1,646 @@
+#ifndef MGSTRINGREF_FLAT_MAP_H
+#define MGSTRINGREF_FLAT_MAP_H
+
+#include "mgstringref.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace mg {
+    // Group of 16 control bytes of the flat map. Masks have one bit per slot of the group.
+    struct __int_flat_group
+    {
+        static constexpr const std::size_t width = 16;
+        // Full slots have 7 bits of the hash in the control byte, free slots have the sign bit set.
+        static constexpr const signed char _Empty = -128;
+        static constexpr const signed char _Deleted = -2;
+
+#ifdef MGSTRINGREF_SIMD
+        explicit __int_flat_group(const signed char* ctrl) :
+            ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+        {}
+
+        std::uint32_t match(signed char h2) const
+        {
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2))));
+        }
+
+        std::uint32_t match_free() const
+        {
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_));
+        }
+
+        __m128i ctrl_;
+#else
+        explicit __int_flat_group(const signed char* ctrl) :
+            ctrl_(ctrl)
+        {}
+
+        std::uint32_t match(signed char h2) const
+        {
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= static_cast<std::uint32_t>(ctrl_[i] == h2) << i;
+            }
+            return mask;
+        }
+
+        std::uint32_t match_free() const
+        {
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= static_cast<std::uint32_t>(ctrl_[i] < 0) << i;
+            }
+            return mask;
+        }
+
+        const signed char* ctrl_;
+#endif
+
+        std::uint32_t match_empty() const
+        {
+            return match(_Empty);
+        }
+
+        static unsigned first_bit(std::uint32_t mask)
+        {
+            return __int_first_bit(mask);
+        }
+
+        // Probing of an empty table stops at this group, so it needs no check of the capacity.
+        static const signed char* empty_group()
+        {
+            static const signed char group[width] = {
+                _Empty, _Empty, _Empty, _Empty, _Empty, _Empty, _Empty, _Empty,
+                _Empty, _Empty, _Empty, _Empty, _Empty, _Empty, _Empty, _Empty
+            };
+            return group;
+        }
+    };
+
+    // Open-addressing hash map with stringref keys (SwissTable layout). Slots are split into groups of 16 with
+    // a control byte per slot, a probe compares the 7-bit hash fragment with the whole group at once, so keys
+    // are compared only on fragment match. Keys are detached on insertion. Lookups accept C strings,
+    // std::basic_string and stringrefs of any traits without a temporary key; keys are compared with _Traits of
+    // the map, so the hash of lookups is the hash of stringref_type.
+    // References and iterators are invalidated by insertion, which grows the table.
+    template<typename _T, typename _CharT, typename _Traits = std::char_traits<_CharT>,
+             typename _Alloc = std::allocator<_CharT>, typename _RefCount = atomic_refcount>
+    class basic_stringref_flat_map
+    {
+    public:
+        typedef basic_stringref<_CharT, _Traits, _Alloc, _RefCount> stringref_type;
+        typedef stringref_type key_type;
+        typedef _T mapped_type;
+        typedef std::pair<const stringref_type, _T> value_type;
+        typedef std::size_t size_type;
+        typedef typename stringref_type::const_pointer const_pointer;
+
+    private:
+        typedef __int_flat_group _Group;
+        typedef __int_search<_Traits> _Search;
+
+        template<typename _Value>
+        class __int_iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef typename std::remove_const<_Value>::type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef _Value* pointer;
+            typedef _Value& reference;
+
+            __int_iterator() :
+                ctrl_(nullptr), slot_(nullptr), end_(nullptr)
+            {}
+
+            // Conversion of iterator to const_iterator.
+            template<typename _Other>
+            __int_iterator(const __int_iterator<_Other>& other) :
+                ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_)
+            {}
+
+            reference operator *() const
+            {
+                return *slot_;
+            }
+
+            pointer operator ->() const
+            {
+                return slot_;
+            }
+
+            __int_iterator& operator ++()
+            {
+                ++ctrl_;
+                ++slot_;
+                __int_skip_free();
+                return *this;
+            }
+
+            __int_iterator operator ++(int)
+            {
+                __int_iterator it(*this);
+                ++(*this);
+                return it;
+            }
+
+            bool operator ==(const __int_iterator& other) const
+            {
+                return (slot_ == other.slot_);
+            }
+
+            bool operator !=(const __int_iterator& other) const
+            {
+                return (slot_ != other.slot_);
+            }
+
+        private:
+            friend class basic_stringref_flat_map;
+            template<typename _Other> friend class __int_iterator;
+
+            __int_iterator(const signed char* ctrl, _Value* slot, const signed char* end) :
+                ctrl_(ctrl), slot_(slot), end_(end)
+            {}
+
+            void __int_skip_free()
+            {
+                while ((ctrl_ != end_) && (*ctrl_ < 0)) {
+                    ++ctrl_;
+                    ++slot_;
+                }
+            }
+
+            const signed char* ctrl_;
+            _Value* slot_;
+            const signed char* end_;
+        };
+
+        // Key of a lookup: characters and the hash, computed once.
+        struct _View {
+            const_pointer data_;
+            size_type size_;
+            std::size_t hash_;
+        };
+
+    public:
+        typedef __int_iterator<value_type> iterator;
+        typedef __int_iterator<const value_type> const_iterator;
+
+        explicit basic_stringref_flat_map(const _Alloc& a = _Alloc()) :
+            a_(a)
+        {}
+
+        basic_stringref_flat_map(const basic_stringref_flat_map& other) :
+            basic_stringref_flat_map(other,
+                                     std::allocator_traits<_Alloc>::select_on_container_copy_construction(other.a_))
+        {}
+
+        basic_stringref_flat_map(const basic_stringref_flat_map& other, const _Alloc& a) :
+            a_(a)
+        {
+            __int_copy_from(other);
+        }
+
+        basic_stringref_flat_map(basic_stringref_flat_map&& other) noexcept :
+            a_(other.a_)
+        {
+            swap(other);
+        }
+
+        ~basic_stringref_flat_map()
+        {
+            __int_destroy();
+        }
+
+        basic_stringref_flat_map& operator =(const basic_stringref_flat_map& other)
+        {
+            if (this != &other) {
+                basic_stringref_flat_map copy(other,
+                    std::allocator_traits<_Alloc>::propagate_on_container_copy_assignment::value ? other.a_ : a_);
+                swap(copy);
+            }
+            return *this;
+        }
+
+        basic_stringref_flat_map& operator =(basic_stringref_flat_map&& other) noexcept
+        {
+            if (this != &other) {
+                basic_stringref_flat_map moved(std::move(other));
+                swap(moved);
+            }
+            return *this;
+        }
+
+        void swap(basic_stringref_flat_map& other) noexcept
+        {
+            std::swap(a_, other.a_);
+            std::swap(ctrl_, other.ctrl_);
+            std::swap(slots_, other.slots_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(group_mask_, other.group_mask_);
+            std::swap(size_, other.size_);
+            std::swap(deleted_, other.deleted_);
+        }
+
+        size_type size() const
+        {
+            return size_;
+        }
+
+        bool empty() const
+        {
+            return (0 == size_);
+        }
+
+        size_type bucket_count() const
+        {
+            return capacity_;
+        }
+
+        iterator begin()
+        {
+            iterator it(ctrl_, slots_, ctrl_ + capacity_);
+            it.__int_skip_free();
+            return it;
+        }
+
+        iterator end()
+        {
+            return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+        }
+
+        const_iterator begin() const
+        {
+            const_iterator it(ctrl_, slots_, ctrl_ + capacity_);
+            it.__int_skip_free();
+            return it;
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+
+        template<typename _Key>
+        iterator find(const _Key& key)
+        {
+            const size_type i = __int_find(__int_view(key));
+            return (_Npos == i) ? end() : iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+        }
+
+        template<typename _Key>
+        const_iterator find(const _Key& key) const
+        {
+            const size_type i = __int_find(__int_view(key));
+            return (_Npos == i) ? end() : const_iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+        }
+
+        template<typename _Key>
+        bool contains(const _Key& key) const
+        {
+            return (_Npos != __int_find(__int_view(key)));
+        }
+
+        template<typename _Key>
+        size_type count(const _Key& key) const
+        {
+            return contains(key) ? 1 : 0;
+        }
+
+        template<typename _Key>
+        _T& at(const _Key& key)
+        {
+            const size_type i = __int_find(__int_view(key));
+            if (_Npos == i) {
+                throw std::out_of_range("basic_stringref_flat_map: key not found");
+            }
+            return slots_[i].second;
+        }
+
+        template<typename _Key>
+        const _T& at(const _Key& key) const
+        {
+            const size_type i = __int_find(__int_view(key));
+            if (_Npos == i) {
+                throw std::out_of_range("basic_stringref_flat_map: key not found");
+            }
+            return slots_[i].second;
+        }
+
+        template<typename _Key>
+        _T& operator [](const _Key& key)
+        {
+            return try_emplace(key).first->second;
+        }
+
+        // Inserts the value constructed from args, if there is no such key. Key is copied only on insertion.
+        template<typename _Key, typename... _Args>
+        std::pair<iterator, bool> try_emplace(const _Key& key, _Args&&... args)
+        {
+            const _View v = __int_view(key);
+            size_type i = __int_find(v);
+            if (_Npos != i) {
+                return std::make_pair(iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), false);
+            }
+            stringref_type k(__int_key(key, v));
+            k.detach();
+            i = __int_prepare_insert(v.hash_);
+            ::new (static_cast<void*>(slots_ + i)) value_type(std::piecewise_construct,
+                std::forward_as_tuple(std::move(k)), std::forward_as_tuple(std::forward<_Args>(args)...));
+            __int_set_ctrl(i, __int_h2(v.hash_));
+            ++size_;
+            return std::make_pair(iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), true);
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return try_emplace(value.first, value.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value)
+        {
+            return try_emplace(value.first, std::move(value.second));
+        }
+
+        template<typename _Key>
+        size_type erase(const _Key& key)
+        {
+            const size_type i = __int_find(__int_view(key));
+            if (_Npos == i) {
+                return 0;
+            }
+            __int_erase(i);
+            return 1;
+        }
+
+        iterator erase(iterator pos)
+        {
+            return erase(const_iterator(pos));
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            const size_type i = static_cast<size_type>(pos.ctrl_ - ctrl_);
+            __int_erase(i);
+            iterator it(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+            it.__int_skip_free();
+            return it;
+        }
+
+        void clear()
+        {
+            __int_destroy();
+            ctrl_ = _Group::empty_group();
+            slots_ = nullptr;
+            capacity_ = 0;
+            group_mask_ = 0;
+            size_ = 0;
+            deleted_ = 0;
+        }
+
+        // Makes room for count elements without rehashing.
+        void reserve(size_type count)
+        {
+            if (count + deleted_ > __int_max_load(capacity_)) {
+                __int_rehash(count);
+            }
+        }
+
+    private:
+        static constexpr const size_type _Npos = ~size_type(0);
+
+        typedef typename std::allocator_traits<_Alloc>::template rebind_alloc<value_type> _Slot_Alloc;
+        typedef typename std::allocator_traits<_Alloc>::template rebind_alloc<signed char> _Ctrl_Alloc;
+
+        static signed char __int_h2(std::size_t hash)
+        {
+            return static_cast<signed char>(hash & 0x7F);
+        }
+
+        static size_type __int_max_load(size_type capacity)
+        {
+            return capacity - capacity / 8;
+        }
+
+        // Hash of the characters, equal to the hash of stringref_type.
+        static std::size_t __int_hash(const_pointer s, size_type n)
+        {
+            return static_cast<std::size_t>(__int_hash_chars<_Traits>(s, n));
+        }
+
+        // Hash of stringref_type keys may be cached in the data block.
+        static _View __int_view(const stringref_type& key)
+        {
+            return _View{key.data(), key.size(), key.hash()};
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        static _View __int_view(const basic_stringref<_CharT, _OTraits, _OAlloc, _ORefCount>& key)
+        {
+            return _View{key.data(), key.size(), __int_hash(key.data(), key.size())};
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        static _View __int_view(const std::basic_string<_CharT, _OTraits, _OAlloc>& key)
+        {
+            return _View{key.data(), key.size(), __int_hash(key.data(), key.size())};
+        }
+
+        template<typename _OTraits>
+        static _View __int_view(const basic_stringref_literal<_CharT, _OTraits>& key)
+        {
+            return _View{key.data(), key.size(), __int_hash(key.data(), key.size())};
+        }
+
+        static _View __int_view(const_pointer key)
+        {
+            const size_type n = (nullptr == key) ? 0 : _Traits::length(key);
+            return _View{key, n, __int_hash(key, n)};
+        }
+
+        // Key for insertion. Copy of stringref_type shares its data block.
+        static stringref_type __int_key(const stringref_type& key, const _View&)
+        {
+            return key;
+        }
+
+        template<typename _Key>
+        stringref_type __int_key(const _Key&, const _View& v) const
+        {
+            return stringref_type(v.data_, v.size_, a_);
+        }
+
+        size_type __int_find(const _View& v) const
+        {
+            const signed char h2 = __int_h2(v.hash_);
+            size_type g = (v.hash_ >> 7) & group_mask_;
+            for (size_type step = 1; ; ++step) {
+                const _Group group(ctrl_ + g * _Group::width);
+                for (std::uint32_t mask = group.match(h2); 0 != mask; mask &= mask - 1) {
+                    const size_type i = g * _Group::width + _Group::first_bit(mask);
+                    const stringref_type& key = slots_[i].first;
+                    if ((key.size() == v.size_) && _Search::equal(key.data(), v.data_, v.size_)) {
+                        return i;
+                    }
+                }
+                if (0 != group.match_empty()) {
+                    return _Npos;
+                }
+                g = (g + step) & group_mask_;
+            }
+        }
+
+        // First free slot of the probe sequence. Table must have a free slot.
+        size_type __int_find_free(std::size_t hash) const
+        {
+            size_type g = (hash >> 7) & group_mask_;
+            for (size_type step = 1; ; ++step) {
+                const std::uint32_t mask = _Group(ctrl_ + g * _Group::width).match_free();
+                if (0 != mask) {
+                    return g * _Group::width + _Group::first_bit(mask);
+                }
+                g = (g + step) & group_mask_;
+            }
+        }
+
+        // Free slot for a new element, the table grows, if it has no room for it.
+        size_type __int_prepare_insert(std::size_t hash)
+        {
+            size_type i = __int_find_free(hash);
+            if (_Group::_Deleted == ctrl_[i]) {
+                --deleted_;
+                return i;
+            }
+            if (size_ + deleted_ + 1 > __int_max_load(capacity_)) {
+                __int_rehash(size_ + 1);
+                i = __int_find_free(hash);
+            }
+            return i;
+        }
+
+        void __int_set_ctrl(size_type i, signed char c)
+        {
+            const_cast<signed char*>(ctrl_)[i] = c;
+        }
+
+        // Probes stop at a group with an empty slot. Such a group has never been full, so no probe went past
+        // it and the erased slot may become empty. Otherwise it is marked deleted.
+        void __int_erase(size_type i)
+        {
+            slots_[i].~value_type();
+            const size_type g = i - i % _Group::width;
+            if (0 != _Group(ctrl_ + g).match_empty()) {
+                __int_set_ctrl(i, _Group::_Empty);
+            } else {
+                __int_set_ctrl(i, _Group::_Deleted);
+                ++deleted_;
+            }
+            --size_;
+        }
+
+        // New table with room for count elements. Deleted slots are dropped.
+        void __int_rehash(size_type count)
+        {
+            size_type capacity = _Group::width;
+            while (__int_max_load(capacity) < count) {
+                capacity *= 2;
+            }
+            _Ctrl_Alloc ctrl_alloc(a_);
+            _Slot_Alloc slot_alloc(a_);
+            signed char* ctrl = std::allocator_traits<_Ctrl_Alloc>::allocate(ctrl_alloc, capacity);
+            value_type* slots;
+            try {
+                slots = std::allocator_traits<_Slot_Alloc>::allocate(slot_alloc, capacity);
+            } catch (...) {
+                std::allocator_traits<_Ctrl_Alloc>::deallocate(ctrl_alloc, ctrl, capacity);
+                throw;
+            }
+            for (size_type i = 0; i < capacity; ++i) {
+                ctrl[i] = _Group::_Empty;
+            }
+            basic_stringref_flat_map old(a_);
+            swap(old);
+            ctrl_ = ctrl;
+            slots_ = slots;
+            capacity_ = capacity;
+            group_mask_ = capacity / _Group::width - 1;
+            for (size_type i = 0; i < old.capacity_; ++i) {
+                if (old.ctrl_[i] >= 0) {
+                    const std::size_t hash = old.slots_[i].first.hash();
+                    const size_type j = __int_find_free(hash);
+                    ::new (static_cast<void*>(slots_ + j)) value_type(std::move(old.slots_[i]));
+                    __int_set_ctrl(j, __int_h2(hash));
+                    ++size_;
+                }
+            }
+        }
+
+        void __int_copy_from(const basic_stringref_flat_map& other)
+        {
+            reserve(other.size_);
+            for (const value_type& value : other) {
+                const std::size_t hash = value.first.hash();
+                const size_type i = __int_find_free(hash);
+                ::new (static_cast<void*>(slots_ + i)) value_type(value);
+                __int_set_ctrl(i, __int_h2(hash));
+                ++size_;
+            }
+        }
+
+        void __int_destroy()
+        {
+            if (0 == capacity_) {
+                return;
+            }
+            for (size_type i = 0; i < capacity_; ++i) {
+                if (ctrl_[i] >= 0) {
+                    slots_[i].~value_type();
+                }
+            }
+            _Ctrl_Alloc ctrl_alloc(a_);
+            _Slot_Alloc slot_alloc(a_);
+            std::allocator_traits<_Ctrl_Alloc>::deallocate(ctrl_alloc, const_cast<signed char*>(ctrl_), capacity_);
+            std::allocator_traits<_Slot_Alloc>::deallocate(slot_alloc, slots_, capacity_);
+        }
+
+        _Alloc a_;
+        const signed char* ctrl_ = _Group::empty_group();
+        value_type* slots_ = nullptr;
+        size_type capacity_ = 0;
+        size_type group_mask_ = 0;
+        size_type size_ = 0;
+        size_type deleted_ = 0;
+    };
+
+    template<typename _T, typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const typename basic_stringref_flat_map<_T, _CharT, _Traits, _Alloc, _RefCount>::size_type
+        basic_stringref_flat_map<_T, _CharT, _Traits, _Alloc, _RefCount>::_Npos;
+
+    template<typename _T>
+    using stringref_flat_map = basic_stringref_flat_map<_T, char>;
+    template<typename _T>
+    using ustringref_flat_map = basic_stringref_flat_map<_T, char16_t>;
+    template<typename _T>
+    using wstringref_flat_map = basic_stringref_flat_map<_T, wchar_t>;
+    template<typename _T>
+    using cistringref_flat_map = basic_stringref_flat_map<_T, char, ci_char_traits<char> >;
+}
+
+#endif // MGSTRINGREF_FLAT_MAP_H
@@ -0,0 +1,158 @@
+#ifndef MGSTRINGREF_HASH_H
+#define MGSTRINGREF_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace mg {
+    // Non-cryptographic hash of byte strings (wyhash). Strings up to 16 bytes are hashed without loops, longer
+    // strings are processed by 48 bytes in three independent lanes. Hash values depend on the byte order.
+    struct __int_wyhash
+    {
+        static constexpr const std::uint64_t _Secret0 = 0xa0761d6478bd642full;
+        static constexpr const std::uint64_t _Secret1 = 0xe7037ed1a0b428dbull;
+        static constexpr const std::uint64_t _Secret2 = 0x8ebc6af09c88c6e3ull;
+        static constexpr const std::uint64_t _Secret3 = 0x589965cc75374cc3ull;
+
+        // 128-bit product of a and b, low half in a, high half in b.
+        static void __int_mum(std::uint64_t& a, std::uint64_t& b)
+        {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t r = static_cast<__uint128_t>(a) * b;
+            a = static_cast<std::uint64_t>(r);
+            b = static_cast<std::uint64_t>(r >> 64);
+#else
+            std::uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<std::uint32_t>(a),
+                lb = static_cast<std::uint32_t>(b);
+            std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+            std::uint64_t t = rl + (rm0 << 32);
+            std::uint64_t c = (t < rl) ? 1 : 0;
+            std::uint64_t lo = t + (rm1 << 32);
+            c += (lo < t) ? 1 : 0;
+            a = lo;
+            b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+        }
+
+        static std::uint64_t __int_mix(std::uint64_t a, std::uint64_t b)
+        {
+            __int_mum(a, b);
+            return a ^ b;
+        }
+
+        static std::uint64_t __int_read8(const unsigned char* p)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static std::uint64_t __int_read4(const unsigned char* p)
+        {
+            std::uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static std::uint64_t __int_read3(const unsigned char* p, std::size_t n)
+        {
+            return (static_cast<std::uint64_t>(p[0]) << 16) | (static_cast<std::uint64_t>(p[n >> 1]) << 8) | p[n - 1];
+        }
+
+        static std::uint64_t hash(const void* key, std::size_t n, std::uint64_t seed = 0)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(key);
+            seed ^= __int_mix(seed ^ _Secret0, _Secret1);
+            std::uint64_t a;
+            std::uint64_t b;
+            if (n <= 16) {
+                if (n >= 4) {
+                    const std::size_t shift = (n >> 3) << 2;
+                    a = (__int_read4(p) << 32) | __int_read4(p + shift);
+                    b = (__int_read4(p + n - 4) << 32) | __int_read4(p + n - 4 - shift);
+                } else if (n > 0) {
+                    a = __int_read3(p, n);
+                    b = 0;
+                } else {
+                    a = b = 0;
+                }
+            } else {
+                std::size_t i = n;
+                if (i > 48) {
+                    std::uint64_t see1 = seed;
+                    std::uint64_t see2 = seed;
+                    do {
+                        seed = __int_mix(__int_read8(p) ^ _Secret1, __int_read8(p + 8) ^ seed);
+                        see1 = __int_mix(__int_read8(p + 16) ^ _Secret2, __int_read8(p + 24) ^ see1);
+                        see2 = __int_mix(__int_read8(p + 32) ^ _Secret3, __int_read8(p + 40) ^ see2);
+                        p += 48;
+                        i -= 48;
+                    } while (i > 48);
+                    seed ^= see1 ^ see2;
+                }
+                while (i > 16) {
+                    seed = __int_mix(__int_read8(p) ^ _Secret1, __int_read8(p + 8) ^ seed);
+                    i -= 16;
+                    p += 16;
+                }
+                a = __int_read8(p + i - 16);
+                b = __int_read8(p + i - 8);
+            }
+            a ^= _Secret1;
+            b ^= seed;
+            __int_mum(a, b);
+            return __int_mix(a ^ _Secret0 ^ n, b ^ _Secret1);
+        }
+    };
+
+    // Hash of the characters, folded with _Traits::__int_fold, so that it is consistent with case-insensitive
+    // equality. Characters are folded into a buffer, hash of each chunk is the seed of the next one.
+    template<typename _Traits>
+    std::uint64_t __int_hash_folded(const typename _Traits::char_type* s, std::size_t n, std::uint64_t seed = 0)
+    {
+        typedef typename _Traits::char_type char_type;
+        const std::size_t chunk = 256 / sizeof(char_type);
+        char_type buf[chunk];
+        std::uint64_t h = seed;
+        if (0 == n) {
+            return __int_wyhash::hash(s, 0, h);
+        }
+        do {
+            const std::size_t len = (n < chunk) ? n : chunk;
+            for (std::size_t i = 0; i < len; ++i) {
+                buf[i] = static_cast<char_type>(_Traits::__int_fold(s[i]));
+            }
+            h = __int_wyhash::hash(buf, len * sizeof(char_type), h);
+            s += len;
+            n -= len;
+        } while (0 != n);
+        return h;
+    }
+
+    // Hash of the characters, consistent with equality of _Traits. Plain characters are hashed as bytes.
+    template<typename _Traits>
+    std::uint64_t __int_hash_chars(const typename _Traits::char_type* s, std::size_t n, std::uint64_t seed,
+                                   std::true_type)
+    {
+        return __int_wyhash::hash(s, n * sizeof(typename _Traits::char_type), seed);
+    }
+
+    template<typename _Traits>
+    std::uint64_t __int_hash_chars(const typename _Traits::char_type* s, std::size_t n, std::uint64_t seed,
+                                   std::false_type)
+    {
+        return __int_hash_folded<_Traits>(s, n, seed);
+    }
+
+    template<typename _Traits>
+    std::uint64_t __int_hash_chars(const typename _Traits::char_type* s, std::size_t n, std::uint64_t seed = 0)
+    {
+        typedef typename _Traits::char_type char_type;
+        return __int_hash_chars<_Traits>(s, n, seed, std::is_same<_Traits, std::char_traits<char_type> >());
+    }
+}
+
+#endif // MGSTRINGREF_HASH_H
@@ -0,0 +1,213 @@
+#ifndef MGSTRINGREF_INTERN_H
+#define MGSTRINGREF_INTERN_H
+
+#include "mgstringref.h"
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+namespace mg {
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount, std::size_t _Shards>
+    class basic_stringref_intern_pool;
+
+    // Handle of a string in the intern pool. Handles of equal strings point to the same pool entry, so they are
+    // compared and hashed as pointers. Default handle is null, it is not equal to any interned string, even the
+    // empty one. The pool must outlive its handles.
+    template<typename _Stringref>
+    class basic_interned_stringref
+    {
+    public:
+        typedef _Stringref stringref_type;
+        typedef typename stringref_type::value_type value_type;
+        typedef typename stringref_type::size_type size_type;
+        typedef typename stringref_type::const_pointer const_pointer;
+
+        basic_interned_stringref() :
+            s_(nullptr)
+        {}
+
+        // Canonical stringref. Copies of it share its data block. Handle must not be null.
+        const stringref_type& str() const
+        {
+            return *s_;
+        }
+
+        const_pointer data() const
+        {
+            return s_ ? s_->data() : nullptr;
+        }
+
+        size_type size() const
+        {
+            return s_ ? s_->size() : 0;
+        }
+
+        bool empty() const
+        {
+            return (0 == size());
+        }
+
+        bool is_null() const
+        {
+            return (nullptr == s_);
+        }
+
+        std::size_t hash() const
+        {
+            return std::hash<const stringref_type*>()(s_);
+        }
+
+        bool operator ==(const basic_interned_stringref& other) const
+        {
+            return (s_ == other.s_);
+        }
+
+        bool operator !=(const basic_interned_stringref& other) const
+        {
+            return (s_ != other.s_);
+        }
+
+    private:
+        template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount, std::size_t _Shards>
+        friend class basic_stringref_intern_pool;
+
+        explicit basic_interned_stringref(const stringref_type* s) :
+            s_(s)
+        {}
+
+        const stringref_type* s_;
+    };
+
+    // Thread-safe pool of canonical strings. Each distinct value is copied once into its own data block, the
+    // first time it is interned; all stringrefs returned for the value share this block. Strings are never
+    // removed from the pool. The pool is split into shards by the hash of the string, each shard has its own
+    // mutex, so threads interning different strings rarely wait for each other.
+    template<typename _CharT, typename _Traits = std::char_traits<_CharT>, typename _Alloc = std::allocator<_CharT>,
+             typename _RefCount = atomic_refcount, std::size_t _Shards = 16>
+    class basic_stringref_intern_pool
+    {
+    public:
+        typedef basic_stringref<_CharT, _Traits, _Alloc, _RefCount> stringref_type;
+        typedef basic_interned_stringref<stringref_type> interned_type;
+        typedef typename stringref_type::value_type value_type;
+        typedef typename stringref_type::size_type size_type;
+        typedef typename stringref_type::const_pointer const_pointer;
+
+        static_assert(_Shards > 0, "Intern pool must have at least one shard.");
+
+        explicit basic_stringref_intern_pool(const _Alloc& a = _Alloc()) :
+            a_(a),
+            empty_(a)
+        {}
+
+        basic_stringref_intern_pool(const basic_stringref_intern_pool&) = delete;
+        basic_stringref_intern_pool& operator =(const basic_stringref_intern_pool&) = delete;
+
+        interned_type intern(const_pointer string, size_type size)
+        {
+            if (0 == size) {
+                return interned_type(&empty_);
+            }
+            // Lookup key does not own the string.
+            _Entry key{stringref_type(string, size, a_), 0};
+            key.hash_ = key.value_.hash();
+            _Shard& shard = shards_[key.hash_ % _Shards];
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            typename _Set::iterator it = shard.set_.find(key);
+            if (shard.set_.end() == it) {
+                key.value_.detach();
+                it = shard.set_.insert(std::move(key)).first;
+            }
+            return interned_type(&it->value_);
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        inline interned_type intern(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string)
+        {
+            return intern(string.data(), string.size());
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        inline interned_type intern(const std::basic_string<value_type, _OTraits, _OAlloc>& string)
+        {
+            return intern(string.data(), string.size());
+        }
+
+        template<typename _OTraits>
+        inline interned_type intern(const basic_stringref_literal<value_type, _OTraits>& string)
+        {
+            return intern(string.data(), string.size());
+        }
+
+        // Number of distinct non-empty strings in the pool.
+        size_type size() const
+        {
+            size_type count = 0;
+            for (const _Shard& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex_);
+                count += shard.set_.size();
+            }
+            return count;
+        }
+
+    private:
+        struct _Entry {
+            stringref_type value_;
+            std::size_t hash_;
+        };
+
+        struct _Entry_Hash {
+            std::size_t operator ()(const _Entry& entry) const noexcept
+            {
+                return entry.hash_;
+            }
+        };
+
+        struct _Entry_Equal {
+            bool operator ()(const _Entry& e1, const _Entry& e2) const
+            {
+                return (e1.hash_ == e2.hash_) && (e1.value_.size() == e2.value_.size())
+                    && (0 == e1.value_.compare(e2.value_));
+            }
+        };
+
+        typedef std::unordered_set<_Entry, _Entry_Hash, _Entry_Equal> _Set;
+
+        // Shards are padded, so that mutexes of different shards are not in the same cache line.
+        struct _Shard {
+            mutable std::mutex mutex_;
+            _Set set_;
+            char pad_[64];
+        };
+
+        _Alloc a_;
+        const stringref_type empty_;
+        _Shard shards_[_Shards];
+    };
+
+    typedef basic_stringref_intern_pool<char> stringref_intern_pool;
+    typedef basic_stringref_intern_pool<char16_t> ustringref_intern_pool;
+    typedef basic_stringref_intern_pool<wchar_t> wstringref_intern_pool;
+
+    typedef stringref_intern_pool::interned_type interned_stringref;
+    typedef ustringref_intern_pool::interned_type interned_ustringref;
+    typedef wstringref_intern_pool::interned_type interned_wstringref;
+}
+
+namespace std {
+    template<typename _Stringref>
+    struct hash<mg::basic_interned_stringref<_Stringref> >
+    {
+        typedef mg::basic_interned_stringref<_Stringref> argument_type;
+        typedef std::size_t result_type;
+
+        std::size_t operator()(const argument_type& s) const noexcept
+        {
+            return s.hash();
+        }
+    };
+}
+
+#endif // MGSTRINGREF_INTERN_H
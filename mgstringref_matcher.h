@@ -0,0 +1,248 @@
+#ifndef MGSTRINGREF_MATCHER_H
+#define MGSTRINGREF_MATCHER_H
+
+#include "mgstringref.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace mg {
+    // Multi-pattern matcher (Aho-Corasick automaton). The haystack is scanned once, matches are reported as
+    // substrings of the haystack, which share its data block, so they can outlive the scan without copying.
+    // Patterns are detached, empty patterns never match. The matcher is immutable after construction and may be
+    // used from several threads at once.
+    template<typename _CharT, typename _Traits = std::char_traits<_CharT>, typename _Alloc = std::allocator<_CharT>,
+             typename _RefCount = atomic_refcount>
+    class basic_stringref_matcher
+    {
+    public:
+        typedef basic_stringref<_CharT, _Traits, _Alloc, _RefCount> stringref_type;
+        typedef typename stringref_type::value_type value_type;
+        typedef typename stringref_type::size_type size_type;
+        typedef typename stringref_type::const_pointer const_pointer;
+
+        struct match
+        {
+            stringref_type text;
+            size_type position;
+            size_type pattern;
+        };
+
+        template<typename _Iterator>
+        basic_stringref_matcher(_Iterator first, _Iterator last) :
+            patterns_(first, last)
+        {
+            __int_build();
+        }
+
+        basic_stringref_matcher(std::initializer_list<stringref_type> patterns) :
+            patterns_(patterns)
+        {
+            __int_build();
+        }
+
+        size_type pattern_count() const
+        {
+            return patterns_.size();
+        }
+
+        const stringref_type& pattern(size_type index) const
+        {
+            return patterns_[index];
+        }
+
+        size_type state_count() const
+        {
+            return pattern_.size();
+        }
+
+        // Calls callback(const match&) for every occurrence of every pattern, in order of the match end.
+        // Callback returns false to stop the scan. Returns false, if the scan was stopped.
+        template<typename _Callback>
+        bool scan(const stringref_type& haystack, _Callback callback) const
+        {
+            const_pointer s = haystack.data();
+            const size_type n = haystack.size();
+            std::uint32_t state = 0;
+            for (size_type i = 0; i < n; ++i) {
+                state = delta_[static_cast<std::size_t>(state) * classes_ + __int_class(s[i])];
+                for (std::uint32_t out = report_[state]; 0 != out; out = report_link_[out]) {
+                    for (std::uint32_t p = pattern_[out]; _No_Pattern != p; p = pattern_next_[p]) {
+                        const size_type len = patterns_[p].size();
+                        const size_type pos = i + 1 - len;
+                        if (!callback(match{stringref_type(haystack, pos, len), pos, p})) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        std::vector<match> find_all(const stringref_type& haystack) const
+        {
+            std::vector<match> matches;
+            scan(haystack, [&matches](const match& m) {
+                matches.push_back(m);
+                return true;
+            });
+            return matches;
+        }
+
+        bool contains_any(const stringref_type& haystack) const
+        {
+            return !scan(haystack, [](const match&) { return false; });
+        }
+
+    private:
+        static constexpr const std::uint32_t _No_Pattern = ~std::uint32_t(0);
+
+        // Characters are mapped to classes, so the transition table has a column per distinct character
+        // of the patterns. Class 0 stands for all other characters.
+        std::uint32_t __int_class(value_type c) const
+        {
+            return __int_class(c, std::integral_constant<bool, (1 == sizeof(value_type))>());
+        }
+
+        std::uint32_t __int_class(value_type c, std::true_type) const
+        {
+            return byte_class_[static_cast<unsigned char>(c)];
+        }
+
+        std::uint32_t __int_class(value_type c, std::false_type) const
+        {
+            typename std::vector<value_type>::const_iterator it =
+                std::lower_bound(chars_.begin(), chars_.end(), c, &_Traits::lt);
+            if ((chars_.end() == it) || (!_Traits::eq(*it, c))) {
+                return 0;
+            }
+            return static_cast<std::uint32_t>(it - chars_.begin()) + 1;
+        }
+
+        void __int_init_classes(std::true_type)
+        {
+            // Characters, which are equal according to the traits, share the class.
+            unsigned char rep[256];
+            __int_byte_classes<_Traits>(rep);
+            bool used[256] = {};
+            for (const stringref_type& p : patterns_) {
+                for (size_type i = 0; i < p.size(); ++i) {
+                    used[rep[static_cast<unsigned char>(p.data()[i])]] = true;
+                }
+            }
+            std::uint32_t rep_class[256] = {};
+            for (unsigned c = 0; c < 256; ++c) {
+                if (used[c]) {
+                    rep_class[c] = classes_++;
+                }
+            }
+            for (unsigned c = 0; c < 256; ++c) {
+                byte_class_[c] = rep_class[rep[c]];
+            }
+        }
+
+        void __int_init_classes(std::false_type)
+        {
+            for (const stringref_type& p : patterns_) {
+                chars_.insert(chars_.end(), p.data(), p.data() + p.size());
+            }
+            std::sort(chars_.begin(), chars_.end(), &_Traits::lt);
+            chars_.erase(std::unique(chars_.begin(), chars_.end(), &_Traits::eq), chars_.end());
+            classes_ = static_cast<std::uint32_t>(chars_.size()) + 1;
+        }
+
+        std::uint32_t __int_add_state()
+        {
+            delta_.resize(delta_.size() + classes_, 0);
+            pattern_.push_back(_No_Pattern);
+            return static_cast<std::uint32_t>(pattern_.size() - 1);
+        }
+
+        void __int_build()
+        {
+            for (stringref_type& pattern : patterns_) {
+                pattern.detach();
+            }
+            __int_init_classes(std::integral_constant<bool, (1 == sizeof(value_type))>());
+
+            // Trie of the patterns. Root is state 0, so 0 in the table of the trie means no transition.
+            __int_add_state();
+            pattern_next_.assign(patterns_.size(), _No_Pattern);
+            for (std::size_t p = 0; p < patterns_.size(); ++p) {
+                const stringref_type& pattern = patterns_[p];
+                if (pattern.empty()) {
+                    continue;
+                }
+                std::uint32_t state = 0;
+                for (size_type i = 0; i < pattern.size(); ++i) {
+                    std::size_t index = static_cast<std::size_t>(state) * classes_ + __int_class(pattern.data()[i]);
+                    if (0 == delta_[index]) {
+                        std::uint32_t next = __int_add_state();
+                        delta_[index] = next;
+                    }
+                    state = delta_[index];
+                }
+                pattern_next_[p] = pattern_[state];
+                pattern_[state] = static_cast<std::uint32_t>(p);
+            }
+
+            // Breadth-first pass adds failure transitions, so the table becomes a complete automaton.
+            // Row of the failure state is always complete, because it is closer to the root.
+            const std::size_t states = pattern_.size();
+            std::vector<std::uint32_t> fail(states, 0);
+            std::vector<std::uint32_t> queue;
+            queue.reserve(states);
+            report_.assign(states, 0);
+            report_link_.assign(states, 0);
+            for (std::uint32_t c = 0; c < classes_; ++c) {
+                if (0 != delta_[c]) {
+                    queue.push_back(delta_[c]);
+                }
+            }
+            for (std::size_t head = 0; head < queue.size(); ++head) {
+                const std::uint32_t r = queue[head];
+                report_link_[r] = report_[fail[r]];
+                report_[r] = (_No_Pattern != pattern_[r]) ? r : report_link_[r];
+                for (std::uint32_t c = 0; c < classes_; ++c) {
+                    std::size_t index = static_cast<std::size_t>(r) * classes_ + c;
+                    std::size_t fail_index = static_cast<std::size_t>(fail[r]) * classes_ + c;
+                    if (0 != delta_[index]) {
+                        fail[delta_[index]] = delta_[fail_index];
+                        queue.push_back(delta_[index]);
+                    } else {
+                        delta_[index] = delta_[fail_index];
+                    }
+                }
+            }
+        }
+
+        std::vector<stringref_type> patterns_;
+        std::uint32_t classes_ = 1;
+        std::uint32_t byte_class_[(1 == sizeof(value_type)) ? 256 : 1];
+        std::vector<value_type> chars_;
+        // Transition table, row per state.
+        std::vector<std::uint32_t> delta_;
+        // First pattern, which ends in the state, and the next pattern with the same end state.
+        std::vector<std::uint32_t> pattern_;
+        std::vector<std::uint32_t> pattern_next_;
+        // Nearest state with patterns in the failure chain, including the state itself, and the next one
+        // after it. 0 means no state, the root never has patterns.
+        std::vector<std::uint32_t> report_;
+        std::vector<std::uint32_t> report_link_;
+    };
+
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const std::uint32_t basic_stringref_matcher<_CharT, _Traits, _Alloc, _RefCount>::_No_Pattern;
+
+    typedef basic_stringref_matcher<char> stringref_matcher;
+    typedef basic_stringref_matcher<char16_t> ustringref_matcher;
+    typedef basic_stringref_matcher<wchar_t> wstringref_matcher;
+    typedef basic_stringref_matcher<char, ci_char_traits<char> > cistringref_matcher;
+    typedef basic_stringref_matcher<char16_t, ci_char_traits<char16_t> > ciustringref_matcher;
+    typedef basic_stringref_matcher<wchar_t, ci_char_traits<wchar_t> > ciwstringref_matcher;
+    typedef basic_stringref_matcher<char, ascii_ci_char_traits<char> > asciicistringref_matcher;
+}
+
+#endif // MGSTRINGREF_MATCHER_H
@@ -0,0 +1,297 @@
+#ifndef MGSTRINGREF_PERFECT_TABLE_H
+#define MGSTRINGREF_PERFECT_TABLE_H
+
+#include "mgstringref.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mg {
+    // Immutable set of strings with a minimal perfect hash (hash and displace). Keys are grouped into buckets by
+    // the hash, every bucket has a pilot, which moves its keys to free slots, so n keys occupy exactly n slots.
+    // Lookup is one hash of the string and one comparison with the key in its slot. Keys are indexed in the order
+    // of construction, they are packed into one data block and exposed as stringrefs sharing it. Keys must be
+    // distinct according to _Traits. The table may be used from several threads at once.
+    template<typename _CharT, typename _Traits = std::char_traits<_CharT>, typename _Alloc = std::allocator<_CharT>,
+             typename _RefCount = atomic_refcount>
+    class basic_stringref_perfect_table
+    {
+    public:
+        typedef basic_stringref<_CharT, _Traits, _Alloc, _RefCount> stringref_type;
+        typedef typename stringref_type::value_type value_type;
+        typedef typename stringref_type::size_type size_type;
+        typedef typename stringref_type::const_pointer const_pointer;
+
+        static constexpr const size_type npos = static_cast<size_type>(-1);
+
+        template<typename _Iterator>
+        basic_stringref_perfect_table(_Iterator first, _Iterator last, const _Alloc& a = _Alloc()) :
+            data_(a)
+        {
+            __int_build(std::vector<stringref_type>(first, last), a);
+        }
+
+        basic_stringref_perfect_table(std::initializer_list<stringref_type> keys, const _Alloc& a = _Alloc()) :
+            data_(a)
+        {
+            __int_build(std::vector<stringref_type>(keys), a);
+        }
+
+        size_type size() const
+        {
+            return keys_.size();
+        }
+
+        bool empty() const
+        {
+            return keys_.empty();
+        }
+
+        // Key with the index, a part of data().
+        const stringref_type& key(size_type index) const
+        {
+            return keys_[index];
+        }
+
+        // All keys in slot order, without separators.
+        const stringref_type& data() const
+        {
+            return data_;
+        }
+
+        // Index of the key or npos.
+        size_type find(const_pointer string, size_type size) const
+        {
+            if (keys_.empty()) {
+                return npos;
+            }
+            const std::uint64_t h = __int_hash_chars<_Traits>(string, size, seed_);
+            const _Slot& slot = slots_[__int_position(h, pilots_[__int_bucket(h)])];
+            const stringref_type& key = keys_[slot.index_];
+            if ((slot.hash_ != h) || (key.size() != size) || !_Search::equal(key.data(), string, size)) {
+                return npos;
+            }
+            return slot.index_;
+        }
+
+        size_type find(const_pointer string) const
+        {
+            return find(string, (nullptr == string) ? 0 : _Traits::length(string));
+        }
+
+        template<typename _OTraits, typename _OAlloc, typename _ORefCount>
+        size_type find(const basic_stringref<value_type, _OTraits, _OAlloc, _ORefCount>& string) const
+        {
+            return find(string.data(), string.size());
+        }
+
+        template<typename _OTraits, typename _OAlloc>
+        size_type find(const std::basic_string<value_type, _OTraits, _OAlloc>& string) const
+        {
+            return find(string.data(), string.size());
+        }
+
+        template<typename _OTraits>
+        size_type find(const basic_stringref_literal<value_type, _OTraits>& string) const
+        {
+            return find(string.data(), string.size());
+        }
+
+        template<typename _Key>
+        bool contains(const _Key& key) const
+        {
+            return (npos != find(key));
+        }
+
+    private:
+        typedef __int_search<_Traits> _Search;
+
+        // Average number of keys in a bucket.
+        static constexpr const size_type _Bucket_Size = 4;
+
+        struct _Slot {
+            std::uint64_t hash_;
+            size_type index_;
+        };
+
+        // High half of the product, maps x uniformly to [0, n).
+        static size_type __int_range(std::uint64_t x, std::uint64_t n)
+        {
+            __int_wyhash::__int_mum(x, n);
+            return static_cast<size_type>(n);
+        }
+
+        size_type __int_bucket(std::uint64_t h) const
+        {
+            return __int_range(h, pilots_.size());
+        }
+
+        size_type __int_position(std::uint64_t h, std::uint32_t pilot) const
+        {
+            return __int_range(__int_wyhash::__int_mix(h ^ __int_wyhash::_Secret2, pilot ^ __int_wyhash::_Secret3),
+                               keys_.size());
+        }
+
+        // Hashes of the keys with the current seed. Returns false, if distinct keys have equal hashes.
+        bool __int_hash_keys(const std::vector<stringref_type>& keys, std::vector<std::uint64_t>& hashes) const
+        {
+            const size_type n = keys.size();
+            std::vector<size_type> order(n);
+            for (size_type i = 0; i < n; ++i) {
+                hashes[i] = __int_hash_chars<_Traits>(keys[i].data(), keys[i].size(), seed_);
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&hashes](size_type i1, size_type i2) {
+                return hashes[i1] < hashes[i2];
+            });
+            for (size_type i = 1; i < n; ++i) {
+                const size_type i1 = order[i - 1];
+                const size_type i2 = order[i];
+                if (hashes[i1] == hashes[i2]) {
+                    if ((keys[i1].size() == keys[i2].size())
+                        && _Search::equal(keys[i1].data(), keys[i2].data(), keys[i1].size())) {
+                        throw std::invalid_argument("basic_stringref_perfect_table: duplicate key");
+                    }
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void __int_build(const std::vector<stringref_type>& keys, const _Alloc& a)
+        {
+            const size_type n = keys.size();
+            if (0 == n) {
+                return;
+            }
+            std::vector<std::uint64_t> hashes(n);
+            keys_.resize(n, stringref_type(a));
+            for (;;) {
+                while (!__int_hash_keys(keys, hashes)) {
+                    ++seed_;
+                }
+                if (__int_place_keys(hashes)) {
+                    break;
+                }
+                ++seed_;
+            }
+
+            // Keys are copied in slot order, so keys of neighbouring slots are close in memory.
+            size_type length = 0;
+            for (const stringref_type& key : keys) {
+                length += key.size();
+            }
+            std::basic_string<value_type> packed;
+            packed.reserve(length);
+            for (const _Slot& slot : slots_) {
+                packed.append(keys[slot.index_].data(), keys[slot.index_].size());
+            }
+            data_ = stringref_type(packed.data(), packed.size(), a);
+            data_.detach();
+            size_type offset = 0;
+            for (const _Slot& slot : slots_) {
+                const size_type len = keys[slot.index_].size();
+                keys_[slot.index_] = stringref_type(data_, offset, len);
+                offset += len;
+            }
+        }
+
+        // Pilots tried for one bucket, before the keys are hashed with another seed. The last buckets have few
+        // free slots to go to, a single key needs about n pilots on average to hit the last one.
+        static std::uint32_t __int_max_pilot(size_type n)
+        {
+            return static_cast<std::uint32_t>(std::min<std::uint64_t>(
+                0xFFFFFFFF, std::max<std::uint64_t>(1 << 16, std::uint64_t(16) * n)));
+        }
+
+        // Finds pilots and slots for the keys with the hashes. Returns false, if a bucket does not fit with any
+        // of the first __int_max_pilot(n) pilots.
+        bool __int_place_keys(const std::vector<std::uint64_t>& hashes)
+        {
+            const size_type n = hashes.size();
+            const std::uint32_t max_pilot = __int_max_pilot(n);
+            pilots_.assign(n / _Bucket_Size + 1, 0);
+
+            // Keys grouped by bucket, buckets are placed from the largest one.
+            std::vector<size_type> bucket_start(pilots_.size() + 1, 0);
+            for (size_type i = 0; i < n; ++i) {
+                ++bucket_start[__int_bucket(hashes[i]) + 1];
+            }
+            for (size_type b = 0; b < pilots_.size(); ++b) {
+                bucket_start[b + 1] += bucket_start[b];
+            }
+            std::vector<size_type> bucket_keys(n);
+            std::vector<size_type> fill(bucket_start.begin(), bucket_start.end() - 1);
+            for (size_type i = 0; i < n; ++i) {
+                bucket_keys[fill[__int_bucket(hashes[i])]++] = i;
+            }
+            std::vector<size_type> buckets(pilots_.size());
+            for (size_type b = 0; b < buckets.size(); ++b) {
+                buckets[b] = b;
+            }
+            std::stable_sort(buckets.begin(), buckets.end(), [&bucket_start](size_type b1, size_type b2) {
+                return (bucket_start[b1 + 1] - bucket_start[b1]) > (bucket_start[b2 + 1] - bucket_start[b2]);
+            });
+
+            std::vector<bool> taken(n, false);
+            std::vector<size_type> positions;
+            slots_.resize(n);
+            for (size_type b : buckets) {
+                const size_type first = bucket_start[b];
+                const size_type last = bucket_start[b + 1];
+                if (first == last) {
+                    break;
+                }
+                for (std::uint32_t pilot = 0; ; ++pilot) {
+                    if (max_pilot == pilot) {
+                        return false;
+                    }
+                    positions.clear();
+                    for (size_type k = first; k < last; ++k) {
+                        const size_type pos = __int_position(hashes[bucket_keys[k]], pilot);
+                        if (taken[pos] || (positions.end() != std::find(positions.begin(), positions.end(), pos))) {
+                            break;
+                        }
+                        positions.push_back(pos);
+                    }
+                    if (positions.size() == last - first) {
+                        pilots_[b] = pilot;
+                        break;
+                    }
+                }
+                for (size_type k = first; k < last; ++k) {
+                    const size_type pos = positions[k - first];
+                    taken[pos] = true;
+                    slots_[pos] = _Slot{hashes[bucket_keys[k]], bucket_keys[k]};
+                }
+            }
+            return true;
+        }
+
+        stringref_type data_;
+        std::vector<stringref_type> keys_;
+        std::vector<_Slot> slots_;
+        std::vector<std::uint32_t> pilots_;
+        std::uint64_t seed_ = 0;
+    };
+
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const typename basic_stringref_perfect_table<_CharT, _Traits, _Alloc, _RefCount>::size_type
+        basic_stringref_perfect_table<_CharT, _Traits, _Alloc, _RefCount>::npos;
+
+    template<typename _CharT, typename _Traits, typename _Alloc, typename _RefCount>
+    constexpr const typename basic_stringref_perfect_table<_CharT, _Traits, _Alloc, _RefCount>::size_type
+        basic_stringref_perfect_table<_CharT, _Traits, _Alloc, _RefCount>::_Bucket_Size;
+
+    typedef basic_stringref_perfect_table<char> stringref_perfect_table;
+    typedef basic_stringref_perfect_table<char16_t> ustringref_perfect_table;
+    typedef basic_stringref_perfect_table<wchar_t> wstringref_perfect_table;
+    typedef basic_stringref_perfect_table<char, ci_char_traits<char> > cistringref_perfect_table;
+}
+
+#endif // MGSTRINGREF_PERFECT_TABLE_H
@@ -0,0 +1,930 @@
+#ifndef MGSTRINGREF_RADIX_TREE_H
+#define MGSTRINGREF_RADIX_TREE_H
+
+#include "mgstringref.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace mg {
+    // Ordered index of stringref keys (adaptive radix tree). Keys are split into bytes, inner nodes grow from 4 to
+    // 16, 48 and 256 children as needed, chains of nodes with one child are collapsed into a prefix of the next
+    // node. Prefixes are not stored: they are read from any key below the node. Lookups skip prefixes and compare
+    // the whole key once at the leaf. Keys are ordered by unsigned code units, a key comes before its extensions.
+    // Stored keys are copies of the inserted stringrefs: they share the data block of the caller, only
+    // stringrefs, which do not own their characters, are detached. Nodes and elements are allocated with _Alloc.
+    // Nodes keep their parent, so iterators hold only the position of the element and are cheap to copy.
+    // Insertion invalidates iterators, but not references to the elements.
+    template<typename _T, typename _CharT, typename _Alloc = std::allocator<_CharT>,
+             typename _RefCount = atomic_refcount>
+    class basic_stringref_radix_tree
+    {
+    public:
+        typedef basic_stringref<_CharT, std::char_traits<_CharT>, _Alloc, _RefCount> stringref_type;
+        typedef stringref_type key_type;
+        typedef _T mapped_type;
+        typedef std::pair<const stringref_type, _T> value_type;
+        typedef std::size_t size_type;
+        typedef typename stringref_type::const_pointer const_pointer;
+
+    private:
+        enum _Kind : unsigned char { _Kind4, _Kind16, _Kind48, _Kind256 };
+
+        struct _Node {
+            explicit _Node(_Kind kind) :
+                kind_(kind), parent_byte_(0), count_(0), prefix_(0), parent_(nullptr), leaf_(nullptr), any_(nullptr)
+            {}
+
+            _Kind kind_;
+            // Byte of the node in the parent.
+            unsigned char parent_byte_;
+            unsigned short count_;
+            // Length of the prefix in bytes.
+            size_type prefix_;
+            // Parent node, nullptr for the root.
+            _Node* parent_;
+            // Key, which ends at the node.
+            value_type* leaf_;
+            // Any key below the node, the prefix is a part of it.
+            const value_type* any_;
+        };
+
+        // Children of _Node4 and _Node16 are sorted by the byte.
+        struct _Node4 : _Node {
+            _Node4() : _Node(_Kind4) {}
+            unsigned char keys_[4];
+            void* children_[4];
+        };
+
+        struct _Node16 : _Node {
+            _Node16() : _Node(_Kind16) {}
+            unsigned char keys_[16];
+            void* children_[16];
+        };
+
+        // Index of the child by the byte, 0 means no child. Children are never removed, so they are appended.
+        struct _Node48 : _Node {
+            _Node48() : _Node(_Kind48), index_() {}
+            unsigned char index_[256];
+            void* children_[48];
+        };
+
+        struct _Node256 : _Node {
+            _Node256() : _Node(_Kind256), children_() {}
+            void* children_[256];
+        };
+
+        // Position of the element: the node and the byte of the leaf in it, -1 for the key of the node. Node of
+        // the key in the root is nullptr.
+        struct _Cursor {
+            explicit _Cursor(const _Node* node = nullptr, int byte = -1, value_type* leaf = nullptr) :
+                node_(node), byte_(byte), leaf_(leaf)
+            {}
+
+            const _Node* node_;
+            int byte_;
+            value_type* leaf_;
+        };
+
+        template<typename _Value>
+        class __int_iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef typename std::remove_const<_Value>::type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef _Value* pointer;
+            typedef _Value& reference;
+
+            __int_iterator() = default;
+
+            // Conversion of iterator to const_iterator.
+            template<typename _Other>
+            __int_iterator(const __int_iterator<_Other>& other) :
+                cursor_(other.cursor_)
+            {}
+
+            reference operator *() const
+            {
+                return *cursor_.leaf_;
+            }
+
+            pointer operator ->() const
+            {
+                return cursor_.leaf_;
+            }
+
+            __int_iterator& operator ++()
+            {
+                basic_stringref_radix_tree::__int_advance(cursor_);
+                return *this;
+            }
+
+            __int_iterator operator ++(int)
+            {
+                __int_iterator it(*this);
+                ++(*this);
+                return it;
+            }
+
+            bool operator ==(const __int_iterator& other) const
+            {
+                return (cursor_.leaf_ == other.cursor_.leaf_);
+            }
+
+            bool operator !=(const __int_iterator& other) const
+            {
+                return (cursor_.leaf_ != other.cursor_.leaf_);
+            }
+
+        private:
+            friend class basic_stringref_radix_tree;
+            template<typename _Other> friend class __int_iterator;
+
+            explicit __int_iterator(const _Cursor& cursor) :
+                cursor_(cursor)
+            {}
+
+            _Cursor cursor_;
+        };
+
+    public:
+        typedef __int_iterator<value_type> iterator;
+        typedef __int_iterator<const value_type> const_iterator;
+
+        explicit basic_stringref_radix_tree(const _Alloc& a = _Alloc()) :
+            a_(a)
+        {}
+
+        basic_stringref_radix_tree(const basic_stringref_radix_tree&) = delete;
+        basic_stringref_radix_tree& operator =(const basic_stringref_radix_tree&) = delete;
+
+        basic_stringref_radix_tree(basic_stringref_radix_tree&& other) noexcept :
+            a_(other.a_)
+        {
+            swap(other);
+        }
+
+        basic_stringref_radix_tree& operator =(basic_stringref_radix_tree&& other) noexcept
+        {
+            if (this != &other) {
+                clear();
+                swap(other);
+            }
+            return *this;
+        }
+
+        ~basic_stringref_radix_tree()
+        {
+            __int_destroy(root_);
+        }
+
+        void swap(basic_stringref_radix_tree& other) noexcept
+        {
+            std::swap(a_, other.a_);
+            std::swap(root_, other.root_);
+            std::swap(size_, other.size_);
+        }
+
+        size_type size() const
+        {
+            return size_;
+        }
+
+        bool empty() const
+        {
+            return (0 == size_);
+        }
+
+        void clear()
+        {
+            __int_destroy(root_);
+            root_ = nullptr;
+            size_ = 0;
+        }
+
+        iterator begin()
+        {
+            iterator it;
+            if (nullptr != root_) {
+                __int_descend_min(it.cursor_, nullptr, -1, root_);
+            }
+            return it;
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+
+        const_iterator begin() const
+        {
+            return const_cast<basic_stringref_radix_tree*>(this)->begin();
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator();
+        }
+
+        iterator find(const stringref_type& key)
+        {
+            iterator it;
+            __int_find(key, it.cursor_);
+            return it;
+        }
+
+        const_iterator find(const stringref_type& key) const
+        {
+            return const_cast<basic_stringref_radix_tree*>(this)->find(key);
+        }
+
+        bool contains(const stringref_type& key) const
+        {
+            _Cursor cursor;
+            return (nullptr != __int_find(key, cursor));
+        }
+
+        size_type count(const stringref_type& key) const
+        {
+            return contains(key) ? 1 : 0;
+        }
+
+        // Mapped value of the key or nullptr.
+        _T* find_value(const stringref_type& key)
+        {
+            _Cursor cursor;
+            value_type* leaf = __int_find(key, cursor);
+            return (nullptr == leaf) ? nullptr : &leaf->second;
+        }
+
+        const _T* find_value(const stringref_type& key) const
+        {
+            _Cursor cursor;
+            const value_type* leaf = __int_find(key, cursor);
+            return (nullptr == leaf) ? nullptr : &leaf->second;
+        }
+
+        _T& operator [](const stringref_type& key)
+        {
+            return __int_insert(key).first.leaf_->second;
+        }
+
+        // Inserts the value constructed from args, if there is no such key.
+        template<typename... _Args>
+        std::pair<iterator, bool> try_emplace(const stringref_type& key, _Args&&... args)
+        {
+            const std::pair<_Cursor, bool> result = __int_insert(key, std::forward<_Args>(args)...);
+            return std::make_pair(iterator(result.first), result.second);
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return try_emplace(value.first, value.second);
+        }
+
+        // First key, which is not less than key.
+        iterator lower_bound(const stringref_type& key)
+        {
+            iterator it;
+            __int_lower_bound(it.cursor_, key.data(), key.size() * sizeof(_CharT));
+            return it;
+        }
+
+        const_iterator lower_bound(const stringref_type& key) const
+        {
+            return const_cast<basic_stringref_radix_tree*>(this)->lower_bound(key);
+        }
+
+        // Calls callback(const value_type&) for keys with the prefix in order. Callback returns false to stop the
+        // scan. Returns false, if the scan was stopped.
+        template<typename _Callback>
+        bool scan_prefix(const stringref_type& prefix, _Callback callback) const
+        {
+            for (const_iterator it = lower_bound(prefix); (end() != it) && it->first.starts_with(prefix); ++it) {
+                if (!callback(*it)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        static constexpr const std::uintptr_t _Leaf_Bit = 1;
+
+        // Leaf, which is deleted, unless it is released to the tree.
+        struct _Leaf_Holder {
+            _Leaf_Holder(basic_stringref_radix_tree* tree, value_type* leaf) :
+                tree_(tree), leaf_(leaf)
+            {}
+
+            ~_Leaf_Holder()
+            {
+                if (nullptr != leaf_) {
+                    tree_->__int_delete(leaf_);
+                }
+            }
+
+            value_type* release()
+            {
+                value_type* leaf = leaf_;
+                leaf_ = nullptr;
+                return leaf;
+            }
+
+            basic_stringref_radix_tree* tree_;
+            value_type* leaf_;
+        };
+
+        static bool __int_is_leaf(const void* p)
+        {
+            return (0 != (reinterpret_cast<std::uintptr_t>(p) & _Leaf_Bit));
+        }
+
+        static value_type* __int_leaf(const void* p)
+        {
+            return reinterpret_cast<value_type*>(reinterpret_cast<std::uintptr_t>(p) & ~_Leaf_Bit);
+        }
+
+        static void* __int_child(value_type* leaf)
+        {
+            return reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(leaf) | _Leaf_Bit);
+        }
+
+        static _Node* __int_node(void* p)
+        {
+            return static_cast<_Node*>(p);
+        }
+
+        // Byte i of the key. Characters are split most significant byte first, so bytes are ordered as
+        // unsigned code units.
+        static unsigned __int_byte(const_pointer s, size_type i)
+        {
+            typedef typename std::make_unsigned<_CharT>::type unsigned_type;
+            const unsigned_type c = static_cast<unsigned_type>(s[i / sizeof(_CharT)]);
+            return static_cast<unsigned>(c >> (8 * (sizeof(_CharT) - 1 - i % sizeof(_CharT)))) & 0xFF;
+        }
+
+        static size_type __int_bytes(const stringref_type& key)
+        {
+            return key.size() * sizeof(_CharT);
+        }
+
+        static bool __int_equal(const stringref_type& key, const_pointer s, size_type bytes)
+        {
+            return (__int_bytes(key) == bytes) && ((0 == bytes) || (0 == std::memcmp(key.data(), s, bytes)));
+        }
+
+        static int __int_compare(const stringref_type& key, const_pointer s, size_type bytes)
+        {
+            const size_type n1 = __int_bytes(key);
+            const size_type n = (n1 < bytes) ? n1 : bytes;
+            for (size_type i = 0; i < n; ++i) {
+                const unsigned b1 = __int_byte(key.data(), i);
+                const unsigned b2 = __int_byte(s, i);
+                if (b1 != b2) {
+                    return (b1 < b2) ? -1 : 1;
+                }
+            }
+            return (n1 < bytes) ? -1 : ((n1 > bytes) ? 1 : 0);
+        }
+
+        static void** __int_find_child(_Node* node, unsigned b)
+        {
+            switch (node->kind_) {
+            case _Kind4: {
+                _Node4* n = static_cast<_Node4*>(node);
+                for (unsigned i = 0; i < n->count_; ++i) {
+                    if (n->keys_[i] == b) {
+                        return &n->children_[i];
+                    }
+                }
+                return nullptr;
+            }
+            case _Kind16: {
+                _Node16* n = static_cast<_Node16*>(node);
+#ifdef MGSTRINGREF_SIMD
+                const __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys_));
+                const __m128i eq = _mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(b)));
+                const std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(eq)) & ((1u << n->count_) - 1);
+                return (0 == mask) ? nullptr : &n->children_[__int_first_bit(mask)];
+#else
+                for (unsigned i = 0; i < n->count_; ++i) {
+                    if (n->keys_[i] == b) {
+                        return &n->children_[i];
+                    }
+                }
+                return nullptr;
+#endif
+            }
+            case _Kind48: {
+                _Node48* n = static_cast<_Node48*>(node);
+                return (0 == n->index_[b]) ? nullptr : &n->children_[n->index_[b] - 1];
+            }
+            default: {
+                _Node256* n = static_cast<_Node256*>(node);
+                return (nullptr == n->children_[b]) ? nullptr : &n->children_[b];
+            }
+            }
+        }
+
+        // Child with the least byte, which is not less than from. Returns the byte or -1.
+        static int __int_next_child(const _Node* node, int from, void*& child)
+        {
+            switch (node->kind_) {
+            case _Kind4:
+                return __int_next_sorted(static_cast<const _Node4*>(node), from, child);
+            case _Kind16:
+                return __int_next_sorted(static_cast<const _Node16*>(node), from, child);
+            case _Kind48: {
+                const _Node48* n = static_cast<const _Node48*>(node);
+                for (int b = from; b < 256; ++b) {
+                    if (0 != n->index_[b]) {
+                        child = n->children_[n->index_[b] - 1];
+                        return b;
+                    }
+                }
+                return -1;
+            }
+            default: {
+                const _Node256* n = static_cast<const _Node256*>(node);
+                for (int b = from; b < 256; ++b) {
+                    if (nullptr != n->children_[b]) {
+                        child = n->children_[b];
+                        return b;
+                    }
+                }
+                return -1;
+            }
+            }
+        }
+
+        template<typename _SortedNode>
+        static int __int_next_sorted(const _SortedNode* n, int from, void*& child)
+        {
+            for (unsigned i = 0; i < n->count_; ++i) {
+                if (n->keys_[i] >= from) {
+                    child = n->children_[i];
+                    return n->keys_[i];
+                }
+            }
+            return -1;
+        }
+
+        template<typename _SortedNode>
+        static void __int_insert_sorted(_SortedNode* n, unsigned b, void* child)
+        {
+            unsigned i = n->count_;
+            for (; (i > 0) && (n->keys_[i - 1] > b); --i) {
+                n->keys_[i] = n->keys_[i - 1];
+                n->children_[i] = n->children_[i - 1];
+            }
+            n->keys_[i] = static_cast<unsigned char>(b);
+            n->children_[i] = child;
+            ++n->count_;
+        }
+
+        template<typename _Type, typename... _Args>
+        _Type* __int_new(_Args&&... args)
+        {
+            typedef typename std::allocator_traits<_Alloc>::template rebind_alloc<_Type> _Type_Alloc;
+            typedef std::allocator_traits<_Type_Alloc> _Type_Traits;
+            _Type_Alloc a(a_);
+            _Type* p = _Type_Traits::allocate(a, 1);
+            try {
+                _Type_Traits::construct(a, p, std::forward<_Args>(args)...);
+            } catch (...) {
+                _Type_Traits::deallocate(a, p, 1);
+                throw;
+            }
+            return p;
+        }
+
+        template<typename _Type>
+        void __int_delete(_Type* p)
+        {
+            typedef typename std::allocator_traits<_Alloc>::template rebind_alloc<_Type> _Type_Alloc;
+            typedef std::allocator_traits<_Type_Alloc> _Type_Traits;
+            _Type_Alloc a(a_);
+            _Type_Traits::destroy(a, p);
+            _Type_Traits::deallocate(a, p, 1);
+        }
+
+        void __int_delete_node(_Node* node)
+        {
+            switch (node->kind_) {
+            case _Kind4:
+                __int_delete(static_cast<_Node4*>(node));
+                break;
+            case _Kind16:
+                __int_delete(static_cast<_Node16*>(node));
+                break;
+            case _Kind48:
+                __int_delete(static_cast<_Node48*>(node));
+                break;
+            default:
+                __int_delete(static_cast<_Node256*>(node));
+                break;
+            }
+        }
+
+        static bool __int_full(const _Node* node)
+        {
+            switch (node->kind_) {
+            case _Kind4:
+                return (4 == node->count_);
+            case _Kind16:
+                return (16 == node->count_);
+            case _Kind48:
+                return (48 == node->count_);
+            default:
+                return false;
+            }
+        }
+
+        // Replaces the full node in slot with a larger one, which becomes the parent of the children.
+        _Node* __int_grow(void** slot)
+        {
+            _Node* node = __int_node(*slot);
+            _Node* grown;
+            switch (node->kind_) {
+            case _Kind4: {
+                const _Node4* n = static_cast<const _Node4*>(node);
+                _Node16* g = __int_new<_Node16>();
+                std::memcpy(g->keys_, n->keys_, sizeof(n->keys_));
+                std::memcpy(g->children_, n->children_, sizeof(n->children_));
+                grown = g;
+                break;
+            }
+            case _Kind16: {
+                const _Node16* n = static_cast<const _Node16*>(node);
+                _Node48* g = __int_new<_Node48>();
+                for (unsigned i = 0; i < 16; ++i) {
+                    g->index_[n->keys_[i]] = static_cast<unsigned char>(i + 1);
+                    g->children_[i] = n->children_[i];
+                }
+                grown = g;
+                break;
+            }
+            default: {
+                const _Node48* n = static_cast<const _Node48*>(node);
+                _Node256* g = __int_new<_Node256>();
+                for (unsigned c = 0; c < 256; ++c) {
+                    if (0 != n->index_[c]) {
+                        g->children_[c] = n->children_[n->index_[c] - 1];
+                    }
+                }
+                grown = g;
+                break;
+            }
+            }
+            grown->parent_byte_ = node->parent_byte_;
+            grown->count_ = node->count_;
+            grown->prefix_ = node->prefix_;
+            grown->parent_ = node->parent_;
+            grown->leaf_ = node->leaf_;
+            grown->any_ = node->any_;
+            void* child;
+            for (int b = __int_next_child(grown, 0, child); b >= 0; b = __int_next_child(grown, b + 1, child)) {
+                if (!__int_is_leaf(child)) {
+                    __int_node(child)->parent_ = grown;
+                }
+            }
+            *slot = grown;
+            __int_delete_node(node);
+            return grown;
+        }
+
+        // Adds the child to the node in slot, replacing the node with a larger one, if it is full.
+        _Node* __int_add_child(void** slot, unsigned b, void* child)
+        {
+            _Node* node = __int_node(*slot);
+            if (__int_full(node)) {
+                node = __int_grow(slot);
+            }
+            switch (node->kind_) {
+            case _Kind4:
+                __int_insert_sorted(static_cast<_Node4*>(node), b, child);
+                break;
+            case _Kind16:
+                __int_insert_sorted(static_cast<_Node16*>(node), b, child);
+                break;
+            case _Kind48: {
+                _Node48* n = static_cast<_Node48*>(node);
+                n->children_[n->count_] = child;
+                n->index_[b] = static_cast<unsigned char>(++n->count_);
+                break;
+            }
+            default: {
+                _Node256* n = static_cast<_Node256*>(node);
+                n->children_[b] = child;
+                ++n->count_;
+                break;
+            }
+            }
+            if (!__int_is_leaf(child)) {
+                __int_node(child)->parent_ = node;
+                __int_node(child)->parent_byte_ = static_cast<unsigned char>(b);
+            }
+            return node;
+        }
+
+        // Puts the leaf into the new node as the key of the node or its child. Returns the position of the leaf.
+        _Cursor __int_place(void** slot, value_type* leaf, size_type depth)
+        {
+            const stringref_type& key = leaf->first;
+            if (__int_bytes(key) == depth) {
+                __int_node(*slot)->leaf_ = leaf;
+                return _Cursor(__int_node(*slot), -1, leaf);
+            }
+            const unsigned b = __int_byte(key.data(), depth);
+            return _Cursor(__int_add_child(slot, b, __int_child(leaf)), static_cast<int>(b), leaf);
+        }
+
+        template<typename... _Args>
+        value_type* __int_new_leaf(const stringref_type& key, _Args&&... args)
+        {
+            stringref_type k(key);
+            k.detach();
+            return __int_new<value_type>(std::piecewise_construct, std::forward_as_tuple(std::move(k)),
+                                         std::forward_as_tuple(std::forward<_Args>(args)...));
+        }
+
+        template<typename... _Args>
+        std::pair<_Cursor, bool> __int_insert(const stringref_type& key, _Args&&... args)
+        {
+            const_pointer s = key.data();
+            const size_type bytes = __int_bytes(key);
+            void** slot = &root_;
+            _Node* parent = nullptr;
+            int byte = -1;
+            size_type depth = 0;
+            for (;;) {
+                if (nullptr == *slot) {
+                    value_type* leaf = __int_new_leaf(key, std::forward<_Args>(args)...);
+                    *slot = __int_child(leaf);
+                    ++size_;
+                    return std::make_pair(_Cursor(parent, byte, leaf), true);
+                }
+                if (__int_is_leaf(*slot)) {
+                    value_type* other = __int_leaf(*slot);
+                    const const_pointer os = other->first.data();
+                    const size_type obytes = __int_bytes(other->first);
+                    const size_type end = (obytes < bytes) ? obytes : bytes;
+                    size_type p = depth;
+                    while ((p < end) && (__int_byte(os, p) == __int_byte(s, p))) {
+                        ++p;
+                    }
+                    if ((p == bytes) && (p == obytes)) {
+                        return std::make_pair(_Cursor(parent, byte, other), false);
+                    }
+                    // Both keys go to a new node with their common part as the prefix.
+                    _Leaf_Holder leaf(this, __int_new_leaf(key, std::forward<_Args>(args)...));
+                    _Node* node = __int_new<_Node4>();
+                    node->prefix_ = p - depth;
+                    node->parent_ = parent;
+                    node->parent_byte_ = static_cast<unsigned char>(byte);
+                    node->any_ = other;
+                    void* n = node;
+                    __int_place(&n, other, p);
+                    const _Cursor position = __int_place(&n, leaf.release(), p);
+                    *slot = n;
+                    ++size_;
+                    return std::make_pair(position, true);
+                }
+                _Node* node = __int_node(*slot);
+                const const_pointer ps = node->any_->first.data();
+                const size_type end = (node->prefix_ < bytes - depth) ? node->prefix_ : bytes - depth;
+                size_type p = 0;
+                while ((p < end) && (__int_byte(ps, depth + p) == __int_byte(s, depth + p))) {
+                    ++p;
+                }
+                if (p < node->prefix_) {
+                    // Key leaves the prefix: the node is split at the first different byte.
+                    _Leaf_Holder leaf(this, __int_new_leaf(key, std::forward<_Args>(args)...));
+                    _Node* split = __int_new<_Node4>();
+                    split->prefix_ = p;
+                    split->parent_ = node->parent_;
+                    split->parent_byte_ = node->parent_byte_;
+                    split->any_ = node->any_;
+                    void* n = split;
+                    __int_add_child(&n, __int_byte(ps, depth + p), node);
+                    node->prefix_ -= p + 1;
+                    const _Cursor position = __int_place(&n, leaf.release(), depth + p);
+                    *slot = n;
+                    ++size_;
+                    return std::make_pair(position, true);
+                }
+                depth += node->prefix_;
+                if (depth == bytes) {
+                    if (nullptr != node->leaf_) {
+                        return std::make_pair(_Cursor(node, -1, node->leaf_), false);
+                    }
+                    node->leaf_ = __int_new_leaf(key, std::forward<_Args>(args)...);
+                    ++size_;
+                    return std::make_pair(_Cursor(node, -1, node->leaf_), true);
+                }
+                const unsigned b = __int_byte(s, depth);
+                void** child = __int_find_child(node, b);
+                if (nullptr == child) {
+                    _Leaf_Holder leaf(this, __int_new_leaf(key, std::forward<_Args>(args)...));
+                    node = __int_add_child(slot, b, __int_child(leaf.leaf_));
+                    ++size_;
+                    return std::make_pair(_Cursor(node, static_cast<int>(b), leaf.release()), true);
+                }
+                parent = node;
+                byte = static_cast<int>(b);
+                slot = child;
+                ++depth;
+            }
+        }
+
+        // Leaf of the key or nullptr. Sets the cursor to the position of the found leaf.
+        value_type* __int_find(const stringref_type& key, _Cursor& cursor) const
+        {
+            const_pointer s = key.data();
+            const size_type bytes = __int_bytes(key);
+            void* p = root_;
+            const _Node* parent = nullptr;
+            int byte = -1;
+            size_type depth = 0;
+            while (nullptr != p) {
+                if (__int_is_leaf(p)) {
+                    value_type* leaf = __int_leaf(p);
+                    if (!__int_equal(leaf->first, s, bytes)) {
+                        return nullptr;
+                    }
+                    cursor = _Cursor(parent, byte, leaf);
+                    return leaf;
+                }
+                _Node* node = __int_node(p);
+                depth += node->prefix_;
+                if (depth >= bytes) {
+                    value_type* leaf = (depth == bytes) ? node->leaf_ : nullptr;
+                    if ((nullptr == leaf) || !__int_equal(leaf->first, s, bytes)) {
+                        return nullptr;
+                    }
+                    cursor = _Cursor(node, -1, leaf);
+                    return leaf;
+                }
+                const unsigned b = __int_byte(s, depth);
+                void** child = __int_find_child(node, b);
+                p = (nullptr == child) ? nullptr : *child;
+                parent = node;
+                byte = static_cast<int>(b);
+                ++depth;
+            }
+            return nullptr;
+        }
+
+        // Moves the cursor to the least key in the subtree p, which is the child of the node at the byte.
+        static void __int_descend_min(_Cursor& cursor, const _Node* node, int byte, void* p)
+        {
+            while (!__int_is_leaf(p)) {
+                node = __int_node(p);
+                if (nullptr != node->leaf_) {
+                    cursor = _Cursor(node, -1, node->leaf_);
+                    return;
+                }
+                byte = __int_next_child(node, 0, p);
+            }
+            cursor = _Cursor(node, byte, __int_leaf(p));
+        }
+
+        // Moves the cursor to the next subtree after its position, going up to the parents.
+        static void __int_advance(_Cursor& cursor)
+        {
+            const _Node* node = cursor.node_;
+            int from = cursor.byte_ + 1;
+            while (nullptr != node) {
+                void* child;
+                const int b = __int_next_child(node, from, child);
+                if (b >= 0) {
+                    __int_descend_min(cursor, node, b, child);
+                    return;
+                }
+                from = node->parent_byte_ + 1;
+                node = node->parent_;
+            }
+            cursor = _Cursor();
+        }
+
+        void __int_lower_bound(_Cursor& cursor, const_pointer s, size_type bytes) const
+        {
+            void* p = root_;
+            const _Node* parent = nullptr;
+            int byte = -1;
+            size_type depth = 0;
+            if (nullptr == p) {
+                return;
+            }
+            for (;;) {
+                if (__int_is_leaf(p)) {
+                    value_type* leaf = __int_leaf(p);
+                    cursor = _Cursor(parent, byte, leaf);
+                    if (__int_compare(leaf->first, s, bytes) < 0) {
+                        __int_advance(cursor);
+                    }
+                    return;
+                }
+                _Node* node = __int_node(p);
+                const const_pointer ps = node->any_->first.data();
+                for (size_type i = 0; i < node->prefix_; ++i) {
+                    if (depth + i == bytes) {
+                        // Key is a prefix of all keys of the subtree.
+                        __int_descend_min(cursor, parent, byte, p);
+                        return;
+                    }
+                    const unsigned b1 = __int_byte(ps, depth + i);
+                    const unsigned b2 = __int_byte(s, depth + i);
+                    if (b1 < b2) {
+                        cursor = _Cursor(parent, byte);
+                        __int_advance(cursor);
+                        return;
+                    }
+                    if (b1 > b2) {
+                        __int_descend_min(cursor, parent, byte, p);
+                        return;
+                    }
+                }
+                depth += node->prefix_;
+                if (depth == bytes) {
+                    __int_descend_min(cursor, parent, byte, p);
+                    return;
+                }
+                const unsigned b = __int_byte(s, depth);
+                void** child = __int_find_child(node, b);
+                if (nullptr == child) {
+                    cursor = _Cursor(node, static_cast<int>(b));
+                    __int_advance(cursor);
+                    return;
+                }
+                p = *child;
+                parent = node;
+                byte = static_cast<int>(b);
+                ++depth;
+            }
+        }
+
+        // Deletes the tree without recursion: children are visited in order, a node is deleted after its last
+        // child, then the walk continues in the parent after the byte of the node.
+        void __int_destroy(void* p)
+        {
+            if (nullptr == p) {
+                return;
+            }
+            if (__int_is_leaf(p)) {
+                __int_delete(__int_leaf(p));
+                return;
+            }
+            _Node* node = __int_node(p);
+            int from = 0;
+            for (;;) {
+                void* child;
+                const int b = __int_next_child(node, from, child);
+                if (b >= 0) {
+                    if (__int_is_leaf(child)) {
+                        __int_delete(__int_leaf(child));
+                        from = b + 1;
+                    } else {
+                        node = __int_node(child);
+                        from = 0;
+                    }
+                    continue;
+                }
+                _Node* parent = node->parent_;
+                from = node->parent_byte_ + 1;
+                if (nullptr != node->leaf_) {
+                    __int_delete(node->leaf_);
+                }
+                __int_delete_node(node);
+                if (nullptr == parent) {
+                    return;
+                }
+                node = parent;
+            }
+        }
+
+        _Alloc a_;
+        void* root_ = nullptr;
+        size_type size_ = 0;
+    };
+
+    template<typename _T, typename _CharT, typename _Alloc, typename _RefCount>
+    constexpr const std::uintptr_t basic_stringref_radix_tree<_T, _CharT, _Alloc, _RefCount>::_Leaf_Bit;
+
+    template<typename _T>
+    using stringref_radix_tree = basic_stringref_radix_tree<_T, char>;
+    template<typename _T>
+    using ustringref_radix_tree = basic_stringref_radix_tree<_T, char16_t>;
+    template<typename _T>
+    using wstringref_radix_tree = basic_stringref_radix_tree<_T, wchar_t>;
+}
+
+#endif // MGSTRINGREF_RADIX_TREE_H
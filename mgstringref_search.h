@@ -0,0 +1,807 @@
+#ifndef MGSTRINGREF_SEARCH_H
+#define MGSTRINGREF_SEARCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if !defined(MGSTRINGREF_NO_SIMD) && defined(__GNUC__)
+#  if defined(__AVX2__)
+#    include <immintrin.h>
+#    define MGSTRINGREF_SIMD 32
+#  elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define MGSTRINGREF_SIMD 16
+#  endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h>
+#endif
+
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_is_constant_evaluated)
+#    define MGSTRINGREF_HAS_IS_CONSTANT_EVALUATED
+#  endif
+#endif
+
+namespace mg {
+    // Index of the lowest set bit, the mask must not be 0.
+    inline unsigned __int_first_bit(std::uint32_t mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        unsigned index = 0;
+        for (; 0 == (mask & 1); mask >>= 1) {
+            ++index;
+        }
+        return index;
+#endif
+    }
+
+    // Character search used by basic_stringref. Functions return index of the found character or npos.
+
+    // Two-Way string matching (Crochemore, Perrin): linear time, constant space. Keeps critical factorization
+    // of the needle, the needle itself is passed to find().
+    template<typename _Traits>
+    class __int_two_way
+    {
+    public:
+        typedef typename _Traits::char_type char_type;
+
+        static constexpr const std::size_t npos = static_cast<std::size_t>(-1);
+
+        // Needle must not be empty.
+        __int_two_way(const char_type* needle, std::size_t m) :
+            m_(m)
+        {
+            std::size_t p = 1;
+            std::size_t q = 1;
+            std::ptrdiff_t i = __int_max_suffix(needle, m, p, false);
+            std::ptrdiff_t j = __int_max_suffix(needle, m, q, true);
+            if (i > j) {
+                ell_ = i;
+                period_ = p;
+            } else {
+                ell_ = j;
+                period_ = q;
+            }
+            // Needle is periodic, if its left part repeats one period later.
+            periodic_ = (static_cast<std::size_t>(ell_ + 1) + period_ <= m);
+            for (std::ptrdiff_t i = 0; periodic_ && (i <= ell_); ++i) {
+                periodic_ = _Traits::eq(needle[i], needle[static_cast<std::size_t>(i) + period_]);
+            }
+            if (!periodic_) {
+                period_ = std::max(static_cast<std::size_t>(ell_ + 1), m - static_cast<std::size_t>(ell_ + 1)) + 1;
+            }
+        }
+
+        std::size_t find(const char_type* s, std::size_t n, const char_type* needle) const
+        {
+            if (m_ > n) {
+                return npos;
+            }
+            const std::ptrdiff_t m = static_cast<std::ptrdiff_t>(m_);
+            const std::size_t last = n - m_;
+            // Prefix of the needle, which is known to match after a shift by the period.
+            std::ptrdiff_t memory = -1;
+            for (std::size_t pos = 0; pos <= last; ) {
+                const char_type* y = s + pos;
+                std::ptrdiff_t i = std::max(ell_, memory) + 1;
+                while ((i < m) && _Traits::eq(needle[i], y[i])) {
+                    ++i;
+                }
+                if (i < m) {
+                    pos += static_cast<std::size_t>(i - ell_);
+                    memory = -1;
+                    continue;
+                }
+                i = ell_;
+                while ((i > memory) && _Traits::eq(needle[i], y[i])) {
+                    --i;
+                }
+                if (i <= memory) {
+                    return pos;
+                }
+                pos += period_;
+                memory = periodic_ ? (m - static_cast<std::ptrdiff_t>(period_) - 1) : -1;
+            }
+            return npos;
+        }
+
+    private:
+        // Returns start of the maximal suffix of the needle minus one, and its period.
+        static std::ptrdiff_t __int_max_suffix(const char_type* x, std::size_t m, std::size_t& period, bool reversed)
+        {
+            std::ptrdiff_t ms = -1;
+            std::size_t j = 0;
+            std::size_t k = 1;
+            period = 1;
+            while (j + k < m) {
+                char_type a = x[j + k];
+                char_type b = x[static_cast<std::size_t>(ms + static_cast<std::ptrdiff_t>(k))];
+                if (_Traits::eq(a, b)) {
+                    if (k == period) {
+                        j += period;
+                        k = 1;
+                    } else {
+                        ++k;
+                    }
+                } else if (reversed ? _Traits::lt(b, a) : _Traits::lt(a, b)) {
+                    j += k;
+                    k = 1;
+                    period = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(j) - ms);
+                } else {
+                    ms = static_cast<std::ptrdiff_t>(j);
+                    j = static_cast<std::size_t>(ms) + 1;
+                    k = period = 1;
+                }
+            }
+            return ms;
+        }
+
+        std::size_t m_;
+        std::ptrdiff_t ell_;
+        std::size_t period_;
+        bool periodic_;
+    };
+
+    template<typename _Traits>
+    constexpr const std::size_t __int_two_way<_Traits>::npos;
+
+    inline std::uint64_t __int_load64(const unsigned char* p)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline std::uint32_t __int_load32(const unsigned char* p)
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline std::uint16_t __int_load16(const unsigned char* p)
+    {
+        std::uint16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // Compares memory by words of 8 bytes, the last word overlaps the previous one. Blocks shorter than a word
+    // are compared by two overlapping halves, so there are no loops for them, and no branches at all, if the
+    // length is known at compile time.
+    inline bool __int_equal_bytes(const unsigned char* a, const unsigned char* b, std::size_t n)
+    {
+        if (n >= 8) {
+            for (std::size_t i = 0; i + 8 < n; i += 8) {
+                if (__int_load64(a + i) != __int_load64(b + i)) {
+                    return false;
+                }
+            }
+            return (__int_load64(a + n - 8) == __int_load64(b + n - 8));
+        }
+        if (n >= 4) {
+            return (0 == ((__int_load32(a) ^ __int_load32(b)) | (__int_load32(a + n - 4) ^ __int_load32(b + n - 4))));
+        }
+        if (n >= 2) {
+            return (0 == ((__int_load16(a) ^ __int_load16(b)) | (__int_load16(a + n - 2) ^ __int_load16(b + n - 2))));
+        }
+        return ((0 == n) || (a[0] == b[0]));
+    }
+
+    template<typename _Traits>
+    struct __int_scalar_search
+    {
+        typedef typename _Traits::char_type char_type;
+
+        static constexpr const std::size_t npos = static_cast<std::size_t>(-1);
+
+        static std::size_t find(const char_type* s, std::size_t n, char_type c)
+        {
+            const char_type* p = _Traits::find(s, n, c);
+            return (nullptr == p) ? npos : static_cast<std::size_t>(p - s);
+        }
+
+        static std::size_t find(const char_type* s, std::size_t n, const char_type* needle, std::size_t m)
+        {
+            if (0 == m) {
+                return 0;
+            }
+            if (m > n) {
+                return npos;
+            }
+            if (1 == m) {
+                return find(s, n, needle[0]);
+            }
+            return __int_two_way<_Traits>(needle, m).find(s, n, needle);
+        }
+
+        static std::size_t rfind(const char_type* s, std::size_t n, char_type c)
+        {
+            while (n-- > 0) {
+                if (_Traits::eq(s[n], c)) {
+                    return n;
+                }
+            }
+            return npos;
+        }
+
+        static std::size_t find_first_of(const char_type* s, std::size_t n, const char_type* set, std::size_t set_n)
+        {
+            return __int_find_first(s, n, set, set_n, false, _Byte_Tag());
+        }
+
+        static std::size_t find_last_of(const char_type* s, std::size_t n, const char_type* set, std::size_t set_n)
+        {
+            return __int_find_last(s, n, set, set_n, false, _Byte_Tag());
+        }
+
+        static std::size_t find_first_not_of(const char_type* s, std::size_t n, const char_type* set,
+                                             std::size_t set_n)
+        {
+            return __int_find_first(s, n, set, set_n, true, _Byte_Tag());
+        }
+
+        static std::size_t find_last_not_of(const char_type* s, std::size_t n, const char_type* set,
+                                            std::size_t set_n)
+        {
+            return __int_find_last(s, n, set, set_n, true, _Byte_Tag());
+        }
+
+        // Plain characters are equal, if their bytes are equal.
+        static bool equal(const char_type* s1, const char_type* s2, std::size_t n)
+        {
+            return __int_equal(s1, s2, n, std::is_same<_Traits, std::char_traits<char_type> >());
+        }
+
+        static bool __int_equal(const char_type* s1, const char_type* s2, std::size_t n, std::true_type)
+        {
+            return __int_equal_bytes(reinterpret_cast<const unsigned char*>(s1),
+                                     reinterpret_cast<const unsigned char*>(s2), n * sizeof(char_type));
+        }
+
+        static bool __int_equal(const char_type* s1, const char_type* s2, std::size_t n, std::false_type)
+        {
+            return (0 == _Traits::compare(s1, s2, n));
+        }
+
+    private:
+        // Plain bytes are looked up in a table of the set, which is built once per search. Small sets and short
+        // strings do not pay for the table and search the set for every character.
+        typedef std::integral_constant<bool, (1 == sizeof(char_type))
+            && std::is_same<_Traits, std::char_traits<char_type> >::value> _Byte_Tag;
+
+        static constexpr const std::size_t _Min_Table_Set = 4;
+        static constexpr const std::size_t _Min_Table_Length = 16;
+
+        struct _Byte_Set {
+            _Byte_Set(const char_type* set, std::size_t set_n) :
+                in_()
+            {
+                for (std::size_t i = 0; i < set_n; ++i) {
+                    in_[static_cast<unsigned char>(set[i])] = true;
+                }
+            }
+
+            bool contains(char_type c) const
+            {
+                return in_[static_cast<unsigned char>(c)];
+            }
+
+            bool in_[256];
+        };
+
+        // Position of the first character, which is in the set, or is not in it, if negate is set.
+        static std::size_t __int_find_first(const char_type* s, std::size_t n, const char_type* set,
+                                            std::size_t set_n, bool negate, std::true_type)
+        {
+            if ((set_n < _Min_Table_Set) || (n < _Min_Table_Length)) {
+                return __int_find_first(s, n, set, set_n, negate, std::false_type());
+            }
+            const _Byte_Set table(set, set_n);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (table.contains(s[i]) != negate) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        static std::size_t __int_find_first(const char_type* s, std::size_t n, const char_type* set,
+                                            std::size_t set_n, bool negate, std::false_type)
+        {
+            for (std::size_t i = 0; i < n; ++i) {
+                if ((nullptr != _Traits::find(set, set_n, s[i])) != negate) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        static std::size_t __int_find_last(const char_type* s, std::size_t n, const char_type* set,
+                                           std::size_t set_n, bool negate, std::true_type)
+        {
+            if ((set_n < _Min_Table_Set) || (n < _Min_Table_Length)) {
+                return __int_find_last(s, n, set, set_n, negate, std::false_type());
+            }
+            const _Byte_Set table(set, set_n);
+            while (n-- > 0) {
+                if (table.contains(s[n]) != negate) {
+                    return n;
+                }
+            }
+            return npos;
+        }
+
+        static std::size_t __int_find_last(const char_type* s, std::size_t n, const char_type* set,
+                                           std::size_t set_n, bool negate, std::false_type)
+        {
+            while (n-- > 0) {
+                if ((nullptr != _Traits::find(set, set_n, s[n])) != negate) {
+                    return n;
+                }
+            }
+            return npos;
+        }
+    };
+
+    template<typename _Traits>
+    constexpr const std::size_t __int_scalar_search<_Traits>::npos;
+
+    template<typename _Traits>
+    struct __int_search : public __int_scalar_search<_Traits>
+    {};
+
+    template<typename _CharT>
+    inline bool __int_is_ascii(_CharT c)
+    {
+        return static_cast<std::uint32_t>(c) < 0x80;
+    }
+
+#ifdef MGSTRINGREF_SIMD
+    // Vector registers of MGSTRINGREF_SIMD bytes. Comparison mask has one bit per byte.
+    struct __int_vec
+    {
+#  if MGSTRINGREF_SIMD == 32
+        typedef __m256i type;
+        typedef std::uint32_t mask_type;
+
+        static type load(const void* p) { return _mm256_loadu_si256(static_cast<const __m256i*>(p)); }
+        static type set1(char c) { return _mm256_set1_epi8(c); }
+        static type set1(char16_t c) { return _mm256_set1_epi16(static_cast<short>(c)); }
+        static type set1(char32_t c) { return _mm256_set1_epi32(static_cast<int>(c)); }
+        static type eq(type a, type b, char) { return _mm256_cmpeq_epi8(a, b); }
+        static type eq(type a, type b, char16_t) { return _mm256_cmpeq_epi16(a, b); }
+        static type eq(type a, type b, char32_t) { return _mm256_cmpeq_epi32(a, b); }
+        static type bit_or(type a, type b) { return _mm256_or_si256(a, b); }
+        static type bit_and(type a, type b) { return _mm256_and_si256(a, b); }
+        static type gt(type a, type b, char) { return _mm256_cmpgt_epi8(a, b); }
+        static type sub(type a, type b, char) { return _mm256_sub_epi8(a, b); }
+        static mask_type mask(type a) { return static_cast<mask_type>(_mm256_movemask_epi8(a)); }
+#  else
+        typedef __m128i type;
+        typedef std::uint32_t mask_type;
+
+        static type load(const void* p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+        static type set1(char c) { return _mm_set1_epi8(c); }
+        static type set1(char16_t c) { return _mm_set1_epi16(static_cast<short>(c)); }
+        static type set1(char32_t c) { return _mm_set1_epi32(static_cast<int>(c)); }
+        static type eq(type a, type b, char) { return _mm_cmpeq_epi8(a, b); }
+        static type eq(type a, type b, char16_t) { return _mm_cmpeq_epi16(a, b); }
+        static type eq(type a, type b, char32_t) { return _mm_cmpeq_epi32(a, b); }
+        static type bit_or(type a, type b) { return _mm_or_si128(a, b); }
+        static type bit_and(type a, type b) { return _mm_and_si128(a, b); }
+        static type gt(type a, type b, char) { return _mm_cmpgt_epi8(a, b); }
+        static type sub(type a, type b, char) { return _mm_sub_epi8(a, b); }
+        static mask_type mask(type a) { return static_cast<mask_type>(_mm_movemask_epi8(a)); }
+#  endif
+
+        static constexpr const std::size_t bytes = MGSTRINGREF_SIMD;
+        static constexpr const mask_type full_mask = static_cast<mask_type>((std::uint64_t(1) << bytes) - 1);
+
+        static unsigned first_bit(mask_type m) { return static_cast<unsigned>(__builtin_ctz(m)); }
+        static unsigned last_bit(mask_type m) { return static_cast<unsigned>(31 - __builtin_clz(m)); }
+    };
+
+    // Vectorized search for plain char and char16_t. Sets of up to _Max_Set characters are compared
+    // in registers, larger sets and strings shorter than one register use the scalar search.
+    template<typename _CharT>
+    struct __int_simd_search
+    {
+        typedef _CharT char_type;
+        typedef std::char_traits<_CharT> _Traits;
+        typedef __int_scalar_search<_Traits> _Scalar;
+        typedef __int_vec::type _Vec;
+        typedef __int_vec::mask_type _Mask;
+
+        static constexpr const std::size_t npos = _Scalar::npos;
+        static constexpr const std::size_t _Lanes = __int_vec::bytes / sizeof(char_type);
+        static constexpr const std::size_t _Max_Set = 16;
+        // Substring search stops skipping, when it has skipped less than _Min_Skip characters per candidate on
+        // average after at least _Min_Skips candidates.
+        static constexpr const std::size_t _Min_Skips = 8;
+        static constexpr const std::size_t _Min_Skip = 4 * _Lanes;
+
+        static std::size_t find(const char_type* s, std::size_t n, char_type c)
+        {
+            if (n < _Lanes) {
+                return _Scalar::find(s, n, c);
+            }
+            _Vec v = __int_vec::set1(c);
+            return __int_find(s, n, &v, 1, false);
+        }
+
+        // The search skips to positions of a rare character of the needle with memchr or a vector scan, and
+        // compares the candidates from there. If the rare character is dense in the string, skipping costs more
+        // than it saves, and if the candidates take too long to compare, the rest of the string is filtered by the
+        // first and the last characters of the needle, which falls back to Two-Way.
+        static std::size_t find(const char_type* s, std::size_t n, const char_type* needle, std::size_t m)
+        {
+            if ((m < 2) || (m > n) || (n - m + 1 < _Lanes)) {
+                return _Scalar::find(s, n, needle, m);
+            }
+            const std::size_t rare = __int_rare_index(needle, m);
+            const std::size_t end = n - m + 1;
+            std::size_t skips = 0;
+            std::size_t skipped = 0;
+            for (std::size_t i = 0; i < end; ++i) {
+                std::size_t skip = __int_skip(s + i + rare, end - i, needle[rare], _Byte_Tag());
+                if (npos == skip) {
+                    return npos;
+                }
+                i += skip;
+                if (0 == _Traits::compare(s + i, needle, m)) {
+                    return i;
+                }
+                skipped += skip;
+                if (((++skips >= _Min_Skips) && (skipped < skips * _Min_Skip)) || (skips * m > 2 * i + 1024)) {
+                    return __int_filter(s, n, needle, m, i + 1);
+                }
+            }
+            return npos;
+        }
+
+        static bool equal(const char_type* s1, const char_type* s2, std::size_t n)
+        {
+            return _Scalar::equal(s1, s2, n);
+        }
+
+        static std::size_t rfind(const char_type* s, std::size_t n, char_type c)
+        {
+            if (n < _Lanes) {
+                return _Scalar::rfind(s, n, c);
+            }
+            _Vec v = __int_vec::set1(c);
+            return __int_rfind(s, n, &v, 1, false);
+        }
+
+        static std::size_t find_first_of(const char_type* s, std::size_t n, const char_type* set, std::size_t set_n)
+        {
+            if ((0 == set_n) || (set_n > _Max_Set) || (n < _Lanes)) {
+                return _Scalar::find_first_of(s, n, set, set_n);
+            }
+            _Vec v[_Max_Set];
+            __int_load_set(v, set, set_n);
+            return __int_find(s, n, v, set_n, false);
+        }
+
+        static std::size_t find_last_of(const char_type* s, std::size_t n, const char_type* set, std::size_t set_n)
+        {
+            if ((0 == set_n) || (set_n > _Max_Set) || (n < _Lanes)) {
+                return _Scalar::find_last_of(s, n, set, set_n);
+            }
+            _Vec v[_Max_Set];
+            __int_load_set(v, set, set_n);
+            return __int_rfind(s, n, v, set_n, false);
+        }
+
+        static std::size_t find_first_not_of(const char_type* s, std::size_t n, const char_type* set,
+                                             std::size_t set_n)
+        {
+            if ((0 == set_n) || (set_n > _Max_Set) || (n < _Lanes)) {
+                return _Scalar::find_first_not_of(s, n, set, set_n);
+            }
+            _Vec v[_Max_Set];
+            __int_load_set(v, set, set_n);
+            return __int_find(s, n, v, set_n, true);
+        }
+
+        static std::size_t find_last_not_of(const char_type* s, std::size_t n, const char_type* set,
+                                            std::size_t set_n)
+        {
+            if ((0 == set_n) || (set_n > _Max_Set) || (n < _Lanes)) {
+                return _Scalar::find_last_not_of(s, n, set, set_n);
+            }
+            _Vec v[_Max_Set];
+            __int_load_set(v, set, set_n);
+            return __int_rfind(s, n, v, set_n, true);
+        }
+
+    private:
+        // Bytes are skipped to with memchr, which the C library tunes for the running CPU.
+        typedef std::integral_constant<bool, 1 == sizeof(char_type)> _Byte_Tag;
+
+        static std::size_t __int_skip(const char_type* s, std::size_t n, char_type c, std::true_type)
+        {
+            return _Scalar::find(s, n, c);
+        }
+
+        static std::size_t __int_skip(const char_type* s, std::size_t n, char_type c, std::false_type)
+        {
+            return find(s, n, c);
+        }
+
+        // Position of the character, which is the rarest in the needle of the first, the middle and the last ones.
+        // Periodic needles, which are common in adversarial inputs, are skipped through by their odd character.
+        static std::size_t __int_rare_index(const char_type* needle, std::size_t m)
+        {
+            const std::size_t candidates[3] = {0, m / 2, m - 1};
+            std::size_t best = 0;
+            std::size_t best_count = m + 1;
+            for (std::size_t candidate : candidates) {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < m; ++i) {
+                    count += (needle[i] == needle[candidate]) ? 1 : 0;
+                }
+                if (count < best_count) {
+                    best = candidate;
+                    best_count = count;
+                }
+            }
+            return best;
+        }
+
+        // Candidates from the position are filtered by the first and the last characters of the needle. If
+        // verification of the candidates takes too long, search continues with Two-Way, so worst case time stays
+        // linear.
+        static std::size_t __int_filter(const char_type* s, std::size_t n, const char_type* needle, std::size_t m,
+                                        std::size_t from)
+        {
+            const std::size_t end = n - m + 1;
+            if (end - from < _Lanes) {
+                std::size_t pos = _Scalar::find(s + from, n - from, needle, m);
+                return (npos == pos) ? npos : from + pos;
+            }
+            const _Vec first = __int_vec::set1(needle[0]);
+            const _Vec last = __int_vec::set1(needle[m - 1]);
+            const _Mask lane_mask = (1u << sizeof(char_type)) - 1;
+            std::size_t checked = 0;
+            for (std::size_t i = from; i < end; ) {
+                if (i + _Lanes > end) {
+                    // Last block overlaps the previous one.
+                    i = end - _Lanes;
+                }
+                _Vec first_eq = __int_vec::eq(__int_vec::load(s + i), first, char_type());
+                _Vec last_eq = __int_vec::eq(__int_vec::load(s + i + m - 1), last, char_type());
+                _Mask mask = __int_vec::mask(__int_vec::bit_and(first_eq, last_eq));
+                while (0 != mask) {
+                    unsigned bit = __int_vec::first_bit(mask);
+                    std::size_t pos = i + bit / sizeof(char_type);
+                    if (0 == _Traits::compare(s + pos + 1, needle + 1, m - 2)) {
+                        return pos;
+                    }
+                    checked += m;
+                    mask &= ~(lane_mask << bit);
+                }
+                i += _Lanes;
+                if ((checked > 2 * (i - from) + 1024) && (i < end)) {
+                    std::size_t pos = __int_two_way<_Traits>(needle, m).find(s + i, n - i, needle);
+                    return (npos == pos) ? npos : i + pos;
+                }
+            }
+            return npos;
+        }
+
+        static void __int_load_set(_Vec* v, const char_type* set, std::size_t set_n)
+        {
+            for (std::size_t i = 0; i < set_n; ++i) {
+                v[i] = __int_vec::set1(set[i]);
+            }
+        }
+
+        // Mask of characters equal to any of the set, or of the other characters, if negate is set.
+        static _Mask __int_match(const char_type* p, const _Vec* set, std::size_t set_n, bool negate)
+        {
+            _Vec data = __int_vec::load(p);
+            _Vec m = __int_vec::eq(data, set[0], char_type());
+            for (std::size_t i = 1; i < set_n; ++i) {
+                m = __int_vec::bit_or(m, __int_vec::eq(data, set[i], char_type()));
+            }
+            _Mask mask = __int_vec::mask(m);
+            return negate ? (~mask & __int_vec::full_mask) : mask;
+        }
+
+        // String must be at least _Lanes long.
+        static std::size_t __int_find(const char_type* s, std::size_t n, const _Vec* set, std::size_t set_n,
+                                      bool negate)
+        {
+            std::size_t i = 0;
+            for (; i + _Lanes <= n; i += _Lanes) {
+                _Mask m = __int_match(s + i, set, set_n, negate);
+                if (0 != m) {
+                    return i + __int_vec::first_bit(m) / sizeof(char_type);
+                }
+            }
+            if (i < n) {
+                // Last block overlaps the previous one, which has no matches.
+                i = n - _Lanes;
+                _Mask m = __int_match(s + i, set, set_n, negate);
+                if (0 != m) {
+                    return i + __int_vec::first_bit(m) / sizeof(char_type);
+                }
+            }
+            return npos;
+        }
+
+        static std::size_t __int_rfind(const char_type* s, std::size_t n, const _Vec* set, std::size_t set_n,
+                                       bool negate)
+        {
+            std::size_t i = n;
+            for (; i >= _Lanes; i -= _Lanes) {
+                _Mask m = __int_match(s + i - _Lanes, set, set_n, negate);
+                if (0 != m) {
+                    return i - _Lanes + __int_vec::last_bit(m) / sizeof(char_type);
+                }
+            }
+            if (0 != i) {
+                // First block overlaps the next one, which has no matches.
+                _Mask m = __int_match(s, set, set_n, negate);
+                if (0 != m) {
+                    return __int_vec::last_bit(m) / sizeof(char_type);
+                }
+            }
+            return npos;
+        }
+    };
+
+    template<typename _CharT>
+    constexpr const std::size_t __int_simd_search<_CharT>::npos;
+
+    // Single chars are searched with memchr, which the C library tunes for the running CPU.
+    template<>
+    struct __int_search<std::char_traits<char> > : public __int_simd_search<char>
+    {
+        using __int_simd_search<char>::find;
+
+        static std::size_t find(const char* s, std::size_t n, char c)
+        {
+            return __int_scalar_search<std::char_traits<char> >::find(s, n, c);
+        }
+    };
+
+    template<>
+    struct __int_search<std::char_traits<char16_t> > : public __int_simd_search<char16_t>
+    {};
+
+    // Converts ASCII lowercase letters to uppercase. Characters must be ASCII.
+    inline __int_vec::type __int_ascii_toupper(__int_vec::type v)
+    {
+        const __int_vec::type before_a = __int_vec::set1(static_cast<char>('a' - 1));
+        const __int_vec::type after_z = __int_vec::set1(static_cast<char>('z' + 1));
+        const __int_vec::type diff = __int_vec::set1(static_cast<char>('a' - 'A'));
+        __int_vec::type lower = __int_vec::bit_and(__int_vec::gt(v, before_a, char()),
+                                                   __int_vec::gt(after_z, v, char()));
+        return __int_vec::sub(v, __int_vec::bit_and(lower, diff), char());
+    }
+
+    // Compares strings case-insensitively, while they are ASCII. Returns length of the equal prefix: it ends
+    // at the first difference or at the first block with non-ASCII characters, which are left to the caller.
+    inline std::size_t __int_ascii_ci_prefix(const char* s1, const char* s2, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + __int_vec::bytes <= n; i += __int_vec::bytes) {
+            __int_vec::type a = __int_vec::load(s1 + i);
+            __int_vec::type b = __int_vec::load(s2 + i);
+            if (0 != __int_vec::mask(__int_vec::bit_or(a, b))) {
+                break;
+            }
+            a = __int_ascii_toupper(a);
+            b = __int_ascii_toupper(b);
+            __int_vec::mask_type diff = __int_vec::mask(__int_vec::eq(a, b, char())) ^ __int_vec::full_mask;
+            if (0 != diff) {
+                return i + __int_vec::first_bit(diff);
+            }
+        }
+        return i;
+    }
+
+    // Case-insensitive search of a character. Lanes equal to the character or to its case variants, which are
+    // ASCII, and all non-ASCII lanes are candidates, verified with _Traits::eq, so the result is exact for any
+    // locale. ASCII text is scanned at the speed of the plain character search.
+    template<typename _Traits>
+    const typename _Traits::char_type* __int_ci_find(const typename _Traits::char_type* s, std::size_t n,
+                                                     typename _Traits::char_type c,
+                                                     typename _Traits::char_type upper,
+                                                     typename _Traits::char_type lower)
+    {
+        typedef typename _Traits::char_type char_type;
+        typedef typename std::conditional<1 == sizeof(char_type), char,
+                typename std::conditional<2 == sizeof(char_type), char16_t, char32_t>::type>::type _Lane;
+        typedef __int_vec::type _Vec;
+        typedef __int_vec::mask_type _Mask;
+
+        const std::size_t lanes = __int_vec::bytes / sizeof(char_type);
+        if (n < lanes) {
+            for (; n; --n, ++s) {
+                if (_Traits::eq(*s, c)) {
+                    return s;
+                }
+            }
+            return nullptr;
+        }
+        const _Vec target = __int_vec::set1(static_cast<_Lane>(c));
+        const _Vec up = __int_vec::set1(static_cast<_Lane>(__int_is_ascii(upper) ? upper : c));
+        const _Vec low = __int_vec::set1(static_cast<_Lane>(__int_is_ascii(lower) ? lower : c));
+        const _Vec high_bits = __int_vec::set1(static_cast<_Lane>(~0x7F));
+        const _Vec zero = __int_vec::set1(static_cast<_Lane>(0));
+        const _Mask lane_mask = (1u << sizeof(char_type)) - 1;
+        auto candidates_of = [&](const char_type* p) -> _Mask {
+            _Vec data = __int_vec::load(p);
+            _Vec eq = __int_vec::bit_or(__int_vec::eq(data, target, _Lane()),
+                                        __int_vec::bit_or(__int_vec::eq(data, up, _Lane()),
+                                                          __int_vec::eq(data, low, _Lane())));
+            if (1 == sizeof(char_type)) {
+                // High bit of a byte is the bit of its lane in the mask.
+                return __int_vec::mask(__int_vec::bit_or(eq, data));
+            }
+            _Mask ascii = __int_vec::mask(__int_vec::eq(__int_vec::bit_and(data, high_bits), zero, _Lane()));
+            return __int_vec::mask(eq) | (~ascii & __int_vec::full_mask);
+        };
+        std::size_t i = 0;
+        // Blocks without candidates are skipped four at a time, as memchr does.
+        for (; i + 4 * lanes <= n; i += 4 * lanes) {
+            if (0 != (candidates_of(s + i) | candidates_of(s + i + lanes) | candidates_of(s + i + 2 * lanes)
+                      | candidates_of(s + i + 3 * lanes))) {
+                break;
+            }
+        }
+        for (; i < n; i += lanes) {
+            if (i + lanes > n) {
+                // Last block overlaps the previous one, which has no matches.
+                i = n - lanes;
+            }
+            _Mask candidates = candidates_of(s + i);
+            while (0 != candidates) {
+                unsigned bit = __int_vec::first_bit(candidates);
+                const char_type* p = s + i + bit / sizeof(char_type);
+                if (_Traits::eq(*p, c)) {
+                    return p;
+                }
+                candidates &= ~(lane_mask << bit);
+            }
+        }
+        return nullptr;
+    }
+#else
+    inline std::size_t __int_ascii_ci_prefix(const char*, const char*, std::size_t)
+    {
+        return 0;
+    }
+
+    template<typename _Traits>
+    const typename _Traits::char_type* __int_ci_find(const typename _Traits::char_type* s, std::size_t n,
+                                                     typename _Traits::char_type c, typename _Traits::char_type,
+                                                     typename _Traits::char_type)
+    {
+        for (; n; --n, ++s) {
+            if (_Traits::eq(*s, c)) {
+                return s;
+            }
+        }
+        return nullptr;
+    }
+#endif
+}
+
+#endif // MGSTRINGREF_SEARCH_H
@@ -0,0 +1,65 @@
+#include "mgstringref_test.h"
+#include "mgstringref_arena.h"
+
+#include <vector>
+
+TEST(Common, Arena)
+{
+    using namespace mg;
+
+    const char str[] = "Test string, which is too long to be stored inline";
+    const wchar_t wstr[] = L"Test string, which is too long to be stored inline";
+    stringref_arena arena(4096);
+    arena_allocator<char> a(arena);
+    EXPECT_EQ(arena.block_count(), static_cast<std::size_t>(0));
+
+    {
+        std::vector<arena_stringref> strings;
+        for (int i = 0; i < 100; i++) {
+            strings.emplace_back(str, arena_stringref::detached, a);
+        }
+        arena_wstringref ws(wstr, arena_wstringref::detached, arena_allocator<wchar_t>(arena));
+        arena_stringref sshort("Test", arena_stringref::detached, a);
+        EXPECT_TRUE(strings.back().is_detached());
+        EXPECT_NE(strings.back().data(), str);
+        EXPECT_EQ(strings.front(), str);
+        EXPECT_EQ(strings.back(), str);
+        EXPECT_EQ(ws, wstr);
+        EXPECT_EQ(sshort, "Test");
+        EXPECT_GT(arena.block_count(), static_cast<std::size_t>(1));
+        EXPECT_GE(arena.allocated(), sizeof(str) * 100);
+
+        // Every allocation must be suitable for data block header.
+        for (const auto& s : strings) {
+            EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(s.data()) % alignof(std::size_t));
+        }
+
+        arena_stringref copy(strings[10], 5, 6);
+        EXPECT_EQ(copy, "string");
+        EXPECT_EQ(copy.data(), strings[10].data() + 5);
+
+        // Data of large strings is allocated in separate blocks.
+        std::string large(10000, 'x');
+        arena_stringref slarge(large, arena_stringref::detached, a);
+        EXPECT_EQ(slarge, large);
+    }
+
+    arena.reset();
+    EXPECT_EQ(arena.block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(arena.allocated(), static_cast<std::size_t>(0));
+
+    arena_stringref s(str, arena_stringref::detached, a);
+    EXPECT_EQ(s, str);
+    EXPECT_EQ(arena.block_count(), static_cast<std::size_t>(1));
+
+    // Data of different arenas is never shared.
+    stringref_arena arena2;
+    arena_allocator<char> a2(arena2);
+    arena_stringref s2(s, 0, s.size(), a2);
+    arena_stringref s3(a2);
+    s3.assign(s);
+    EXPECT_NE(s2.data(), s.data());
+    EXPECT_NE(s3.data(), s.data());
+    EXPECT_EQ(s2, str);
+    EXPECT_EQ(s3, str);
+}
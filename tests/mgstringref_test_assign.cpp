@@ -1,5 +1,8 @@
 #include "mgstringref_test.h"
 
+#include <algorithm>
+#include <vector>
+
 TEST_F(StandardAllocator, AssingFromOthers)
 {
     char str[] = "Test string";
@@ -102,7 +105,7 @@ TEST_F(CustomAllocator, AssingFromOthers)
 
     s.assign(str, stringref::detached);
     ws.assign(wstr, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s, "Test string");
     EXPECT_EQ(ws, L"Test string");
@@ -116,7 +119,7 @@ TEST_F(CustomAllocator, AssingFromOthers)
 
     s.assign(str, 4, stringref::detached);
     ws.assign(wstr, 4, stringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s, "Test");
     EXPECT_EQ(ws, L"Test");
@@ -130,7 +133,7 @@ TEST_F(CustomAllocator, AssingFromOthers)
 
     s.assign(str, 5, 6, stringref::detached);
     ws.assign(wstr, 5, 6, stringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s, "string");
     EXPECT_EQ(ws, L"string");
@@ -144,8 +147,8 @@ TEST_F(CustomAllocator, AssingFromOthers)
 
     s.assign(str, 4, 1, 10, stringref::detached);
     ws.assign(wstr, 4, 1, 10, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
-    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(s, "est");
     EXPECT_EQ(ws, L"est");
 
@@ -158,7 +161,7 @@ TEST_F(CustomAllocator, AssingFromOthers)
 
     s.assign(sstr, stringref::detached);
     ws.assign(wsstr, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s, "Test string");
     EXPECT_EQ(ws, L"Test string");
@@ -172,21 +175,21 @@ TEST_F(CustomAllocator, AssingFromOthers)
 
     s.assign(sstr, 5, 6, stringref::detached);
     ws.assign(wsstr, 5, 6, stringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s, "string");
     EXPECT_EQ(ws, L"string");
 
     s.assign(std::string("Test string"));
     ws.assign(std::wstring(L"Test string"));
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s, "Test string");
     EXPECT_EQ(ws, L"Test string");
 
     s.assign(std::string("Test string"), 5, 6);
     ws.assign(std::wstring(L"Test string"), 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s, "string");
     EXPECT_EQ(ws, L"string");
@@ -312,14 +315,14 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     using namespace inplace;
     stringref source("Test string", stringref::detached, a);
     wstringref wsource(L"Test string", wstringref::detached, a2);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
 
     stringref s01(source);
     wstringref ws01(wsource);
     s01.assign("");
     ws01.assign(L"");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s01.empty());
     EXPECT_TRUE(ws01.empty());
@@ -328,7 +331,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws02(wsource);
     s02.assign("", stringref::detached);
     ws02.assign(L"", wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s02.empty());
     EXPECT_TRUE(ws02.empty());
@@ -337,7 +340,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws03(wsource);
     s03.assign("Test", 0);
     ws03.assign(L"Test", 0);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s03.empty());
     EXPECT_TRUE(ws03.empty());
@@ -346,7 +349,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws04(wsource);
     s04.assign("Test", 0, stringref::detached);
     ws04.assign(L"Test", 0, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s04.empty());
     EXPECT_TRUE(ws04.empty());
@@ -355,7 +358,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws05(wsource);
     s05.assign("Test", 5, 6);
     ws05.assign(L"Test", 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s05.empty());
     EXPECT_TRUE(ws05.empty());
@@ -364,7 +367,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws06(wsource);
     s06.assign("Test", 5, 6, stringref::detached);
     ws06.assign(L"Test", 5, 6, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s06.empty());
     EXPECT_TRUE(ws06.empty());
@@ -373,7 +376,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws07(wsource);
     s07.assign("Test", 4, 5, 6);
     ws07.assign(L"Test", 4, 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s07.empty());
     EXPECT_TRUE(ws07.empty());
@@ -382,7 +385,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws08(wsource);
     s08.assign("Test", 4, 5, 6, stringref::detached);
     ws08.assign(L"Test", 4, 5, 6, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s08.empty());
     EXPECT_TRUE(ws08.empty());
@@ -391,7 +394,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws09(wsource);
     s09.assign(strempty);
     ws09.assign(wstrempty);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s09.empty());
     EXPECT_TRUE(ws09.empty());
@@ -400,7 +403,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws10(wsource);
     s10.assign(strempty, stringref::detached);
     ws10.assign(wstrempty, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s10.empty());
     EXPECT_TRUE(ws10.empty());
@@ -409,7 +412,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws11(wsource);
     s11.assign(str, 5, 6);
     ws11.assign(wstr, 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s11.empty());
     EXPECT_TRUE(ws11.empty());
@@ -418,7 +421,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws12(wsource);
     s12.assign(str, 5, 6, stringref::detached);
     ws12.assign(wstr, 5, 6, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s12.empty());
     EXPECT_TRUE(ws12.empty());
@@ -427,7 +430,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws13(wsource);
     s13.assign(std::string{});
     ws13.assign(std::wstring{});
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s13.empty());
     EXPECT_TRUE(ws13.empty());
@@ -436,7 +439,7 @@ TEST_F(CustomAllocator, AssingFromOthersEmpty)
     wstringref ws14(wsource);
     s14.assign(std::string("Test"), 5, 6);
     ws14.assign(std::wstring(L"Test"), 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s14.empty());
     EXPECT_TRUE(ws14.empty());
@@ -467,7 +470,7 @@ TEST_F(CustomAllocator, AssingFromSelfOtherAllocator)
     EXPECT_EQ(ws01, L"Test string");
     s01.assign(scopy);
     ws01.assign(wscopy);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s01, "Test string");
     EXPECT_EQ(ws01, L"Test string");
@@ -485,13 +488,13 @@ TEST_F(CustomAllocator, AssingFromSelfOtherAllocator)
     wstringref ws02(a2);
     s02.assign(sref, stringref::detached);
     ws02.assign(wsref, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s02, "Test string");
     EXPECT_EQ(ws02, L"Test string");
     s02.assign(scopy, stringref::detached);
     ws02.assign(wscopy, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s02, "Test string");
     EXPECT_EQ(ws02, L"Test string");
@@ -515,13 +518,13 @@ TEST_F(CustomAllocator, AssingFromSelfOtherAllocator)
     EXPECT_EQ(ws03, L"string");
     s03.assign(scopy, 5, 6);
     ws03.assign(wscopy, 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s03, "string");
     EXPECT_EQ(ws03, L"string");
     s03.assign(scopy, 5, 100);
     ws03.assign(wscopy, 5, 100);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s03, "string");
     EXPECT_EQ(ws03, L"string");
@@ -545,19 +548,19 @@ TEST_F(CustomAllocator, AssingFromSelfOtherAllocator)
     wstringref ws04(a2);
     s04.assign(sref, 5, 6, stringref::detached);
     ws04.assign(wsref, 5, 6, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s04, "string");
     EXPECT_EQ(ws04, L"string");
     s04.assign(scopy, 5, 6, stringref::detached);
     ws04.assign(wscopy, 5, 6, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s04, "string");
     EXPECT_EQ(ws04, L"string");
     s04.assign(scopy, 5, 100, stringref::detached);
     ws04.assign(wscopy, 5, 100, wstringref::detached);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s04, "string");
     EXPECT_EQ(ws04, L"string");
@@ -635,7 +638,7 @@ TEST_F(CustomAllocator, CopyAssingFromSelf)
     wstringref wscopy(L"Test string", wstringref::detached, a2);
     stringref sempty(a);
     wstringref wsempty(a2);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
 
 //    basic_stringref& assign(const basic_stringref& other);
@@ -645,19 +648,19 @@ TEST_F(CustomAllocator, CopyAssingFromSelf)
     wstringref ws01(a2);
     EXPECT_EQ(s01.assign(sref), "Test string");
     EXPECT_EQ(ws01.assign(wsref), L"Test string");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(s01.assign(scopy), "Test string");
     EXPECT_EQ(ws01.assign(wscopy), L"Test string");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_TRUE(s01.assign(sempty).empty());
     EXPECT_TRUE(ws01.assign(wsempty).empty());
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
@@ -669,26 +672,26 @@ TEST_F(CustomAllocator, CopyAssingFromSelf)
     wstringref ws02(a2);
     EXPECT_EQ(s02.assign(sref, stringref::detached), "Test string");
     EXPECT_EQ(ws02.assign(wsref, wstringref::detached), L"Test string");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s02.assign(scopy, stringref::detached), "Test string");
     EXPECT_EQ(ws02.assign(wscopy, wstringref::detached), L"Test string");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(1));
-    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(0));
     EXPECT_TRUE(s02.assign(sempty).empty());
     EXPECT_TRUE(ws02.assign(wsempty).empty());
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(1));
 
 //    basic_stringref& assign(const basic_stringref& other, size_type offset, size_type length);
     a.clear_usage();
@@ -697,19 +700,19 @@ TEST_F(CustomAllocator, CopyAssingFromSelf)
     wstringref ws03(a2);
     EXPECT_EQ(s03.assign(sref, 5, 6), "string");
     EXPECT_EQ(ws03.assign(wsref, 5, 6), L"string");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(s03.assign(scopy, 5, 6), "string");
     EXPECT_EQ(ws03.assign(wscopy, 5, 6), L"string");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_TRUE(s03.assign(scopy, 12, 5).empty());
     EXPECT_TRUE(ws03.assign(wscopy, 12, 5).empty());
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
@@ -721,24 +724,224 @@ TEST_F(CustomAllocator, CopyAssingFromSelf)
     wstringref ws04(a2);
     EXPECT_EQ(s04.assign(sref, 5, 6, stringref::detached), "string");
     EXPECT_EQ(ws04.assign(wsref, 5, 6, wstringref::detached), L"string");
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s04.assign(scopy, 5, 6, stringref::detached), "string");
     EXPECT_EQ(ws04.assign(wscopy, 5, 6, wstringref::detached), L"string");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(0));
+    EXPECT_TRUE(s04.assign(scopy, 12, 5, stringref::detached).empty());
+    EXPECT_TRUE(ws04.assign(wscopy, 12, 5, wstringref::detached).empty());
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(1));
+}
+
+TEST_F(CustomAllocator, AssignReusesOwnedData)
+{
+    using namespace inplace;
+    char str[] = "Test string, which is too long to be stored inline";
+    wchar_t wstr[] = L"Test string, which is too long to be stored inline";
+    stringref s(str, stringref::detached, a);
+    wstringref ws(wstr, wstringref::detached, a2);
+    const char* sdata = s.data();
+    const wchar_t* wsdata = ws.data();
+    a.clear_usage();
+    a2.clear_usage();
+
+    for (int i = 0; i < 100; i++) {
+        s.assign(str, stringref::detached);
+        ws.assign(wstr, wstringref::detached);
+        s.assign(str, 5, 6, stringref::detached);
+        ws.assign(wstr, 5, 6, wstringref::detached);
+    }
+    EXPECT_EQ(s, "string");
+    EXPECT_EQ(ws, L"string");
+    EXPECT_EQ(s.data(), sdata);
+    EXPECT_EQ(ws.data(), wsdata);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(0));
+
+    // Assign from a part of own data.
+    s.assign(str, stringref::detached);
+    ws.assign(wstr, wstringref::detached);
+    s.assign(s, 5, 6, stringref::detached);
+    ws.assign(ws, 5, 6, wstringref::detached);
+    EXPECT_EQ(s, "string");
+    EXPECT_EQ(ws, L"string");
+    EXPECT_EQ(s.data(), sdata);
+    EXPECT_EQ(ws.data(), wsdata);
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(0));
+
+    // Shared data must not be overwritten.
+    stringref scopy(s);
+    wstringref wscopy(ws);
+    s.assign(str, stringref::detached);
+    ws.assign(wstr, wstringref::detached);
+    EXPECT_EQ(s, str);
+    EXPECT_EQ(ws, wstr);
+    EXPECT_EQ(scopy, "string");
+    EXPECT_EQ(wscopy, L"string");
     EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
+
+    // Too small data block must be reallocated.
+    std::string long_str(200, 'x');
+    s.assign(long_str, stringref::detached);
+    EXPECT_EQ(s, long_str);
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(2));
     EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(1));
-    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(1));
-    EXPECT_TRUE(s04.assign(scopy, 12, 5, stringref::detached).empty());
-    EXPECT_TRUE(ws04.assign(wscopy, 12, 5, wstringref::detached).empty());
+}
+
+TEST_F(CustomAllocator, AssignInline)
+{
+    using namespace inplace;
+    stringref s(a);
+    wstringref ws(a2);
+
+    s.assign("Test string", stringref::detached);
+    ws.assign(L"Tst", wstringref::detached);
+    EXPECT_TRUE(s.is_detached());
+    EXPECT_TRUE(ws.is_detached());
+    EXPECT_EQ(s, "Test string");
+    EXPECT_EQ(ws, L"Tst");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(0));
+
+    s.assign(s, 5, 6, stringref::detached);
+    ws.assign(ws, 1, 2, wstringref::detached);
+    EXPECT_EQ(s, "string");
+    EXPECT_EQ(ws, L"st");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(0));
+
+    s.assign("Test string, which is too long to be stored inline", stringref::detached);
+    ws.assign(L"Test string", wstringref::detached);
+    EXPECT_EQ(s, "Test string, which is too long to be stored inline");
+    EXPECT_EQ(ws, L"Test string");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+
+    stringref scopy(s, 5, 6);
+    wstringref wscopy(ws, 5, 6);
+    EXPECT_EQ(scopy, "string");
+    EXPECT_EQ(wscopy, L"string");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+
+    s.assign("Test", stringref::detached);
+    ws.assign(L"Tst", wstringref::detached);
+    scopy.assign(s);
+    wscopy.assign(ws);
+    EXPECT_EQ(s, "Test");
+    EXPECT_EQ(ws, L"Tst");
+    EXPECT_EQ(scopy, "Test");
+    EXPECT_EQ(wscopy, L"Tst");
+    EXPECT_NE(s.data(), scopy.data());
+    EXPECT_NE(ws.data(), wscopy.data());
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+}
+
+TEST_F(CustomAllocator, MoveAssign)
+{
+    using namespace inplace;
+    char str[] = "Test string, which is too long to be stored inline";
+
+    stringref s1(str, stringref::detached, a);
+    stringref s2(a);
+    s2.assign(std::move(s1));
+    EXPECT_TRUE(s1.empty());
+    EXPECT_EQ(s2, str);
     EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+
+    // Data of other allocator must be copied.
+    stringref s3(a2);
+    s3.assign(std::move(s2));
+    EXPECT_TRUE(s2.empty());
+    EXPECT_EQ(s3, str);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+
+    stringref s4(str, a);
+    stringref s5(a);
+    s5.assign(std::move(s4), stringref::detached);
+    EXPECT_TRUE(s4.empty());
+    EXPECT_TRUE(s5.is_detached());
+    EXPECT_EQ(s5, str);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+
+    const char* data = s5.data();
+    stringref s6(a);
+    s6.assign(std::move(s5), 5, 6);
+    EXPECT_TRUE(s5.empty());
+    EXPECT_EQ(s6, "string");
+    EXPECT_EQ(s6.data(), data + 5);
+
+    s6.assign(std::move(s6), 1, 3);
+    EXPECT_EQ(s6, "tri");
+    EXPECT_EQ(s6.data(), data + 6);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a2.dealloc_count(), static_cast<std::size_t>(2));
+
+    stringref s7(a);
+    s7 = s6;
+    EXPECT_EQ(s7, "tri");
+    EXPECT_EQ(s7.data(), s6.data());
+    s7 = std::move(s6);
+    EXPECT_TRUE(s6.empty());
+    EXPECT_EQ(s7, "tri");
+    s7 = s7;
+    s7 = std::move(s7);
+    EXPECT_EQ(s7, "tri");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+
+    stringref s8("Short", stringref::detached, a);
+    swap(s7, s8);
+    EXPECT_EQ(s7, "Short");
+    EXPECT_EQ(s8, "tri");
+    s8.swap(s8);
+    EXPECT_EQ(s8, "tri");
+    s8 = stringref(a);
+    EXPECT_TRUE(s8.empty());
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
+}
+
+TEST_F(StandardAllocator, MoveInContainers)
+{
+    using namespace mg;
+    static_assert(std::is_nothrow_move_constructible<stringref>::value, "stringref must be nothrow movable.");
+    static_assert(std::is_nothrow_move_assignable<stringref>::value, "stringref must be nothrow movable.");
+
+    std::vector<stringref> v;
+    for (int i = 0; i < 100; ++i) {
+        v.push_back(stringref(std::to_string(100 - i) + " test string, which is long enough", stringref::detached));
+    }
+    std::vector<const char*> data;
+    for (const stringref& s : v) {
+        data.push_back(s.data());
+    }
+    std::sort(v.begin(), v.end());
+    std::sort(data.begin(), data.end(), [](const char* s1, const char* s2) { return strcmp(s1, s2) < 0; });
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        EXPECT_EQ(v[i].data(), data[i]);
+    }
 }
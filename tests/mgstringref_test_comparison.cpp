@@ -214,7 +214,7 @@ TEST_F(CustomAllocator, CompareFullCopy)
     using namespace inplace;
     stringref s(std::string("ccc"), a);
     wstringref ws(std::wstring(L"ccc"), a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
 
     CompareTest(s, ws);
 }
@@ -233,7 +233,7 @@ TEST_F(CustomAllocator, ComparePartialCopy)
     using namespace inplace;
     stringref s(std::string("aaacccddd"), 3, 3, a);
     wstringref ws(std::wstring(L"aaacccddd"), 3, 3, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
 
     CompareTest(s, ws);
 }
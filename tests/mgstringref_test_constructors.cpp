@@ -1,5 +1,9 @@
 #include "mgstringref_test.h"
 
+#if defined(__unix__)
+#include <sys/mman.h>
+#endif
+
 TEST_F(StandardAllocator, EmptyConstrution)
 {
     using namespace mg;
@@ -174,31 +178,31 @@ TEST_F(CustomAllocator, MoveConstrutionFromStdString)
     using namespace inplace;
     stringref s(std::string("Test string"), a);
     wstringref ws(std::wstring(L"Test string"), a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s.size(), static_cast<std::size_t>(11));
     EXPECT_EQ(ws.size(), static_cast<std::size_t>(11));
 
     stringref s1(std::string{}, a);
     wstringref ws1(std::wstring{}, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_TRUE(s1.empty());
     EXPECT_TRUE(ws1.empty());
 
     stringref s2(std::string("Test string"), 5, 6, a);
     wstringref ws2(std::wstring(L"Test string"), 5, 6, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
     EXPECT_EQ(s2.size(), static_cast<std::size_t>(6));
     EXPECT_EQ(ws2.size(), static_cast<std::size_t>(6));
 
     stringref s3(std::string("Test string"), 5, 10, a);
     wstringref ws3(std::wstring(L"Test string"), 5, 10, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
     EXPECT_EQ(s3.size(), static_cast<std::size_t>(6));
     EXPECT_EQ(ws3.size(), static_cast<std::size_t>(6));
 
     stringref s4(std::string("Test string"), 11, 4, a);
     wstringref ws4(std::wstring(L"Test string"), 11, 4, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
     EXPECT_TRUE(s4.empty());
     EXPECT_TRUE(ws4.empty());
 }
@@ -259,29 +263,29 @@ TEST_F(CustomAllocator, CopyConstruction)
 
     stringref scopy(std::string("ccc"), a);
     wstringref wscopy(std::wstring(L"ccc"), a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
 
     stringref scopy_copy1(scopy);
     wstringref wscopy_copy1(wscopy);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(scopy_copy1, "ccc");
     EXPECT_EQ(wscopy_copy1, L"ccc");
 
     stringref scopy_copy2(scopy, 1, 1, a);
     wstringref wscopy_copy2(wscopy, 1, 1, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(scopy_copy2, "c");
     EXPECT_EQ(wscopy_copy2, L"c");
 
     mg::stringref scopy_copy3(scopy, 1, 1);
     mg::wstringref wscopy_copy3(wscopy, 1, 1);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(scopy_copy3, "c");
     EXPECT_EQ(wscopy_copy3, L"c");
 
     stringref scopy_copy4(sref, 1, 1, a);
     wstringref wscopy_copy4(wsref, 1, 1, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(scopy_copy4, "c");
     EXPECT_EQ(wscopy_copy4, L"c");
 }
@@ -320,17 +324,17 @@ TEST_F(CustomAllocator, CopyConstructionWithOffsetAndLenght)
     {
         stringref s(std::string("Test string"), a);
         wstringref ws(std::wstring(L"Test string"), a);
-        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
 
         stringref s1(s, 5, 6);
         wstringref ws1(ws, 5, 6);
-        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
         EXPECT_EQ(s1, "string");
         EXPECT_EQ(ws1, L"string");
 
         stringref s2(s, 5, 0);
         wstringref ws2(ws, 5, 0);
-        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
         EXPECT_TRUE(s2.empty());
         EXPECT_TRUE(ws2.empty());
     }
@@ -338,14 +342,14 @@ TEST_F(CustomAllocator, CopyConstructionWithOffsetAndLenght)
 
     stringref *s = new stringref(std::string("Test string"), a);
     wstringref *ws = new wstringref(std::wstring(L"Test string"), a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
 
     stringref s1(*s, 5, 6);
     wstringref ws1(*ws, 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
     delete s;
     delete ws;
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s1, "string");
     EXPECT_EQ(ws1, L"string");
 }
@@ -393,32 +397,32 @@ TEST_F(CustomAllocator, MoveConstruction)
 
     stringref s2(stringref(std::string("Test string"), a));
     wstringref ws2(wstringref(std::wstring(L"Test string"), a));
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(s2, "Test string");
     EXPECT_EQ(ws2, L"Test string");
 
     stringref s3(stringref("Test string", a), 5, 6);
     wstringref ws3(wstringref(L"Test string", a), 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(s3, "string");
     EXPECT_EQ(ws3, L"string");
 
     stringref s4(stringref("Test string", a), 5, 0);
     wstringref ws4(wstringref(L"Test string", a), 5, 0);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(s4, "");
     EXPECT_EQ(ws4, L"");
 
     stringref s5(stringref(std::string("Test string"), a), 5, 6);
     wstringref ws5(wstringref(std::wstring(L"Test string"), a), 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
-    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
     EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(s5, "string");
     EXPECT_EQ(ws5, L"string");
@@ -461,39 +465,39 @@ TEST_F(CustomAllocator, DetachedConstructors)
     using namespace inplace;
     stringref s1("Test string", stringref::detached, a);
     wstringref ws1(L"Test string", wstringref::detached, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s1, "Test string");
     EXPECT_EQ(ws1, L"Test string");
 
     stringref s2("Test string", a);
     wstringref ws2(L"Test string", a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s2, "Test string");
     EXPECT_EQ(ws2, L"Test string");
 
     stringref s3("Test string", 4, stringref::detached, a);
     wstringref ws3(L"Test string", 4, wstringref::detached, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
     EXPECT_EQ(s3, "Test");
     EXPECT_EQ(ws3, L"Test");
 
     stringref s4("Test string", 5, 6, stringref::detached, a);
     wstringref ws4(L"Test string", 5, 6, wstringref::detached, a);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
     EXPECT_EQ(s4, "string");
     EXPECT_EQ(ws4, L"string");
 
     stringref s5(s1, a2);
     wstringref ws5(ws1, a2);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
-    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s5, "Test string");
     EXPECT_EQ(ws5, L"Test string");
 
     stringref s6(s2, a2);
     wstringref ws6(ws2, a2);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
-    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s6, "Test string");
     EXPECT_EQ(ws6, L"Test string");
 
@@ -502,22 +506,279 @@ TEST_F(CustomAllocator, DetachedConstructors)
 
     stringref s7(ss, a2);
     wstringref ws7(wss, a2);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
-    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s7, "Test string");
     EXPECT_EQ(ws7, L"Test string");
 
     stringref s8(ss, stringref::detached, a2);
     wstringref ws8(wss, wstringref::detached, a2);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
-    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
     EXPECT_EQ(s8, "Test string");
     EXPECT_EQ(ws8, L"Test string");
 
     stringref s9(ss, 5, 6, stringref::detached, a2);
     wstringref ws9(wss, 5, 6, wstringref::detached, a2);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(6));
-    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(6));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(3));
     EXPECT_EQ(s9, "string");
     EXPECT_EQ(ws9, L"string");
 }
+
+TEST_F(StandardAllocator, InlineConstruction)
+{
+    using namespace mg;
+    char str[] = "Test string";
+    wchar_t wstr[] = L"Test";
+
+    stringref s1(str, stringref::detached);
+    wstringref ws1(wstr, wstringref::detached);
+    EXPECT_TRUE(s1.is_detached());
+    EXPECT_TRUE(ws1.is_detached());
+    EXPECT_NE(s1.data(), str);
+    EXPECT_NE(ws1.data(), wstr);
+
+    stringref s2(s1);
+    wstringref ws2(ws1);
+    stringref s3(s1, 5, 6);
+    wstringref ws3(ws1, 1, 2);
+    stringref s4(std::move(s1));
+    wstringref ws4(std::move(ws1));
+    EXPECT_TRUE(s1.empty());
+    EXPECT_TRUE(ws1.empty());
+    EXPECT_FALSE(s1.is_detached());
+    EXPECT_FALSE(ws1.is_detached());
+
+    memset(str, 0, sizeof(str));
+    memset(wstr, 0, sizeof(wstr));
+    EXPECT_TRUE(s2.is_detached());
+    EXPECT_TRUE(ws2.is_detached());
+    EXPECT_EQ(s2, "Test string");
+    EXPECT_EQ(ws2, L"Test");
+    EXPECT_EQ(s3, "string");
+    EXPECT_EQ(ws3, L"es");
+    EXPECT_EQ(s4, "Test string");
+    EXPECT_EQ(ws4, L"Test");
+}
+
+TEST_F(CustomAllocator, InlineConstruction)
+{
+    using namespace inplace;
+    stringref s1("Test string", stringref::detached, a);
+    wstringref ws1(L"Tst", wstringref::detached, a2);
+    stringref s2(std::string("ccc"), a);
+    wstringref ws2(std::wstring(L"ccc"), a2);
+    stringref s3(std::string("aaacccddd"), 3, 3, a);
+    wstringref ws3(std::wstring(L"aaacccddd"), 3, 3, a2);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_TRUE(s1.is_detached());
+    EXPECT_TRUE(ws1.is_detached());
+    EXPECT_EQ(s2, "ccc");
+    EXPECT_EQ(ws2, L"ccc");
+    EXPECT_EQ(s3, "ccc");
+    EXPECT_EQ(ws3, L"ccc");
+
+    // Copies of inline strings are inline too, even with other allocator.
+    stringref s4(s1, 5, 6, a);
+    wstringref ws4(ws1, 1, 2, a2);
+    stringref s5(s1, a2);
+    wstringref ws5(ws1, a);
+    stringref s6(std::move(s2));
+    wstringref ws6(std::move(ws2));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(s4, "string");
+    EXPECT_EQ(ws4, L"st");
+    EXPECT_EQ(s5, "Test string");
+    EXPECT_EQ(ws5, L"Tst");
+    EXPECT_EQ(s6, "ccc");
+    EXPECT_EQ(ws6, L"ccc");
+
+    // Short substring of a shared block is shared, not copied inline.
+    stringref s7("Test string, which is too long to be stored inline", stringref::detached, a);
+    stringref s8(s7, 5, 6);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(s8.data(), s7.data() + 5);
+    s7.assign("Test", stringref::detached);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(s8, "string");
+
+    // Uniquely owned block is reused for a copy of an inline string.
+    s8.assign(s7);
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.dealloc_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(s8, "Test");
+    EXPECT_EQ(s8.data(), s8.terminated_data());
+}
+
+TEST_F(CustomAllocator, CompactLayout)
+{
+    using namespace inplace;
+    if (8 == sizeof(void*)) {
+        EXPECT_EQ(sizeof(mg::stringref), static_cast<std::size_t>(16));
+    }
+
+    // 15 chars fit into the two words, 16 chars do not.
+    stringref s1("Fifteen chars!!", stringref::detached, a);
+    stringref s2("Sixteen chars!!!", stringref::detached, a);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(s1, "Fifteen chars!!");
+    EXPECT_EQ(s2, "Sixteen chars!!!");
+    EXPECT_EQ(s1.size(), static_cast<std::size_t>(15));
+    EXPECT_EQ(s2.size(), static_cast<std::size_t>(16));
+
+    // Substrings of shared data keep the offset in the length word.
+    stringref s3(s2, 8, 5);
+    stringref s4(s3, 1, 3);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(s3, "chars");
+    EXPECT_EQ(s4, "har");
+    EXPECT_EQ(s4.data(), s2.data() + 9);
+    EXPECT_TRUE(s4.is_detached());
+
+    stringref s5(std::move(s3), 2, 2);
+    EXPECT_TRUE(s3.empty());
+    EXPECT_EQ(s5, "ar");
+    EXPECT_EQ(s5.data(), s2.data() + 10);
+}
+
+TEST_F(CustomAllocator, AdoptStdString)
+{
+    using namespace inplace;
+    a.clear_usage();
+    {
+        string str("Test string, which is too long to be stored inline", a2);
+        const char* data = str.data();
+        stringref s(std::move(str), a);
+        EXPECT_TRUE(s.is_detached());
+        EXPECT_EQ(s.data(), data);
+        EXPECT_EQ(s, "Test string, which is too long to be stored inline");
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+        EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+
+        string str2("Test string, which is too long to be stored inline", a2);
+        data = str2.data();
+        stringref s2(std::move(str2), 5, 31, a);
+        EXPECT_EQ(s2.data(), data + 5);
+        EXPECT_EQ(s2, "string, which is too long to be");
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
+
+        stringref s3(s2);
+        s2.assign(string("Other string, which is too long to be stored inline", a2));
+        EXPECT_EQ(s2, "Other string, which is too long to be stored inline");
+        EXPECT_EQ(s3, "string, which is too long to be");
+        EXPECT_EQ(s3.data(), data + 5);
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+        EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(3));
+
+        // Short strings are copied inline.
+        s3.assign(string("Test", a2));
+        EXPECT_EQ(s3, "Test");
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
+
+        // Adopted data is never reused.
+        s.assign("Test string, which is too long", stringref::detached);
+        EXPECT_EQ(s, "Test string, which is too long");
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+    }
+    EXPECT_EQ(a.alloc_count(), a.dealloc_count());
+}
+
+#if defined(__unix__) && (8 == __SIZEOF_POINTER__)
+namespace {
+    // Characters are not written on construction, so the pages of a huge string are never committed.
+    struct lazy_char_traits : public std::char_traits<char> {
+        using std::char_traits<char>::assign;
+
+        static char* assign(char* s, std::size_t n, char c)
+        {
+            (void)n;
+            (void)c;
+            return s;
+        }
+    };
+
+    template<typename T>
+    struct mmap_allocator {
+        typedef T value_type;
+
+        mmap_allocator() = default;
+
+        template<typename U>
+        mmap_allocator(const mmap_allocator<U>&)
+        {}
+
+        T* allocate(std::size_t n)
+        {
+            void* p = mmap(nullptr, n * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                           -1, 0);
+            if (MAP_FAILED == p) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, std::size_t n)
+        {
+            munmap(p, n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator ==(const mmap_allocator<U>&) const
+        {
+            return true;
+        }
+
+        template<typename U>
+        bool operator !=(const mmap_allocator<U>&) const
+        {
+            return false;
+        }
+    };
+}
+
+TEST_F(StandardAllocator, SpilledOffsetAndLength)
+{
+    using namespace mg;
+    const std::size_t length = (static_cast<std::size_t>(1) << 32) + 64;
+    const std::size_t offset = static_cast<std::size_t>(1) << 31;
+    std::basic_string<char, lazy_char_traits, mmap_allocator<char> > str(length, 'a');
+    char* data = &str[0];
+    memcpy(data + offset, "Test string", 11);
+
+    // Length above 2^32 is kept in a spill block.
+    stringref s(std::move(str));
+    EXPECT_EQ(s.size(), length);
+    EXPECT_EQ(s.data(), data);
+
+    // Substrings with large offsets and lengths share the adopted string.
+    stringref s1(s, offset, 11);
+    EXPECT_EQ(s1.data(), data + offset);
+    EXPECT_EQ(s1, "Test string");
+    stringref s2(s, 1, length - 2);
+    EXPECT_EQ(s2.data(), data + 1);
+    EXPECT_EQ(s2.size(), length - 2);
+    stringref s3(s2, offset - 1, 4);
+    EXPECT_EQ(s3, "Test");
+    stringref s4(s, 5, 10);
+    EXPECT_EQ(s4.data(), data + 5);
+    EXPECT_EQ(s4.size(), static_cast<std::size_t>(10));
+
+    stringref s5(std::move(s2), 1, length - 3);
+    EXPECT_TRUE(s2.empty());
+    EXPECT_EQ(s5.data(), data + 2);
+    EXPECT_EQ(s5.size(), length - 3);
+    stringref s6(std::move(s1));
+    EXPECT_TRUE(s1.empty());
+    EXPECT_EQ(s6, "Test string");
+
+    s.assign(s6, 5, 6);
+    EXPECT_EQ(s, "string");
+    EXPECT_EQ(s.data(), data + offset + 5);
+}
+#endif
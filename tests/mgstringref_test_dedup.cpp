@@ -0,0 +1,207 @@
+#include "mgstringref_test.h"
+
+#include <thread>
+#include <vector>
+
+namespace {
+    // Reference counter with only the members required by basic_stringref.
+    class minimal_refcount
+    {
+    public:
+        explicit minimal_refcount(int ref) :
+            ref_(ref)
+        {}
+
+        void add_ref()
+        {
+            ++ref_;
+        }
+
+        bool release()
+        {
+            return (0 == (--ref_));
+        }
+
+        bool unique() const
+        {
+            return (1 == ref_);
+        }
+
+    private:
+        int ref_;
+    };
+
+    // Disables deduplication at the end of the test, even if it fails.
+    struct dedup_scope {
+        dedup_scope()
+        {
+            mg::stringref::set_dedup(true);
+        }
+
+        ~dedup_scope()
+        {
+            mg::stringref::set_dedup(false);
+        }
+    };
+}
+
+TEST(Common, Dedup)
+{
+    using namespace mg;
+    EXPECT_FALSE(stringref::dedup_enabled());
+    const stringref_dedup_stats before = stringref::dedup_stats();
+    std::string text("a string, which is too long to be stored inline");
+    {
+        dedup_scope scope;
+        EXPECT_TRUE(stringref::dedup_enabled());
+        stringref s1(text.data(), text.size());
+        s1.detach();
+        stringref s2(text.data(), text.size(), stringref::detached);
+        stringref s3;
+        s3.assign(text, stringref::detached);
+        EXPECT_EQ(s1, text.c_str());
+        EXPECT_NE(s1.data(), text.data());
+        EXPECT_EQ(s1.data(), s2.data());
+        EXPECT_EQ(s1.data(), s3.data());
+
+        stringref_dedup_stats stats = stringref::dedup_stats();
+        EXPECT_EQ(stats.blocks, before.blocks + 1);
+        EXPECT_EQ(stats.hits, before.hits + 2);
+        EXPECT_EQ(stats.bytes_saved, before.bytes_saved + 2 * text.size());
+
+        // Different content, a prefix of the string and short inline strings get their own storage.
+        stringref s4(text.data(), text.size() - 1, stringref::detached);
+        EXPECT_NE(s4.data(), s1.data());
+        stringref s5("short", stringref::detached);
+        stringref s6("short", stringref::detached);
+        EXPECT_NE(s5.data(), s6.data());
+        EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks + 2);
+
+        // Shared block is not modified by an assignment into one of its owners.
+        s2 = stringref();
+        s3.assign(text.data(), text.size() - 2, stringref::detached);
+        EXPECT_EQ(s1, text.c_str());
+        EXPECT_NE(s3.data(), s1.data());
+        EXPECT_EQ(s3.size(), text.size() - 2);
+        EXPECT_EQ(s1.hash(), stringref(text.data(), text.size()).hash());
+
+        // Block is removed from the set with the last owner, equal content gets a new block.
+        s1 = stringref();
+        EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks + 2);
+        s3 = stringref();
+        s4 = stringref();
+        EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks);
+        stringref s7(text.data(), text.size(), stringref::detached);
+        EXPECT_EQ(s7, text.c_str());
+        EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks + 1);
+    }
+    EXPECT_FALSE(stringref::dedup_enabled());
+    EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks);
+
+    // Blocks allocated with deduplication disabled are not shared.
+    stringref s1(text.data(), text.size(), stringref::detached);
+    stringref s2(text.data(), text.size(), stringref::detached);
+    EXPECT_NE(s1.data(), s2.data());
+}
+
+TEST(Common, DedupOutlivesMode)
+{
+    using namespace mg;
+    const stringref_dedup_stats before = stringref::dedup_stats();
+    std::string text("a string, which is too long to be stored inline");
+    stringref s1;
+    {
+        dedup_scope scope;
+        s1.assign(text, stringref::detached);
+    }
+    // Pooled block stays shared and is released after the mode is disabled.
+    stringref s2(s1);
+    EXPECT_EQ(s2.data(), s1.data());
+    s2 = stringref(text.data(), text.size(), stringref::detached);
+    EXPECT_NE(s2.data(), s1.data());
+    EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks + 1);
+    s1 = stringref();
+    EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks);
+}
+
+TEST(Common, DedupOtherTraits)
+{
+    using namespace mg;
+    const stringref_dedup_stats before = stringref::dedup_stats();
+    std::string text("a string, which is too long to be stored inline");
+    {
+        dedup_scope scope;
+        EXPECT_TRUE(cistringref::dedup_enabled());
+        stringref s1(text.data(), text.size(), stringref::detached);
+        cistringref ci(s1);
+        EXPECT_EQ(ci.data(), s1.data());
+        stringref s2(text.data(), text.size(), stringref::detached);
+        EXPECT_EQ(s2.data(), s1.data());
+
+        // The copy with other traits outlives the stringrefs and removes the block from the set.
+        s1 = stringref();
+        s2 = stringref();
+        EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks + 1);
+        ci = cistringref();
+        EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks);
+
+        stringref s3(text.data(), text.size(), stringref::detached);
+        EXPECT_EQ(s3, text.c_str());
+        EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks + 1);
+    }
+    EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks);
+}
+
+TEST(Common, DedupThreads)
+{
+    using namespace mg;
+    const stringref_dedup_stats before = stringref::dedup_stats();
+    const std::size_t thread_count = 4;
+    const std::size_t string_count = 64;
+    std::vector<std::string> strings;
+    for (std::size_t i = 0; i < string_count; ++i) {
+        strings.push_back("shared.metric.name.number." + std::to_string(i));
+    }
+    std::vector<std::vector<stringref> > results(thread_count);
+    {
+        dedup_scope scope;
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&strings, &results, t]() {
+                for (std::size_t round = 0; round < 100; ++round) {
+                    for (const std::string& string : strings) {
+                        stringref s(string.data(), string.size(), stringref::detached);
+                        if (0 == round) {
+                            results[t].push_back(s);
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks + string_count);
+    for (std::size_t t = 1; t < thread_count; ++t) {
+        for (std::size_t i = 0; i < string_count; ++i) {
+            EXPECT_EQ(results[t][i].data(), results[0][i].data());
+            EXPECT_EQ(results[t][i], strings[i].c_str());
+        }
+    }
+    results.clear();
+    EXPECT_EQ(stringref::dedup_stats().blocks, before.blocks);
+}
+
+TEST(Common, DedupNotRequired)
+{
+    typedef mg::basic_stringref<char, std::char_traits<char>, std::allocator<char>, minimal_refcount> stringref;
+    EXPECT_FALSE(stringref::dedup_enabled());
+    std::string text("a string, which is too long to be stored inline");
+    stringref s1(text.data(), text.size(), stringref::detached);
+    stringref s2(s1);
+    EXPECT_EQ(s1.data(), s2.data());
+    s1.assign(text, stringref::detached);
+    EXPECT_NE(s1.data(), s2.data());
+    EXPECT_EQ(s1, s2);
+}
@@ -0,0 +1,328 @@
+#include "mgstringref_test.h"
+
+#include <random>
+
+namespace {
+    // Compares search results with std::basic_string for every position of strings of various lengths,
+    // so that both vector blocks and tails are covered.
+    template<typename _Stringref>
+    void CheckFind(const std::basic_string<typename _Stringref::value_type>& str,
+                   const std::basic_string<typename _Stringref::value_type>& set)
+    {
+        typedef typename _Stringref::value_type char_type;
+        typedef std::basic_string<char_type> string_type;
+
+        for (std::size_t len = 0; len <= str.size(); ++len) {
+            string_type s(str, 0, len);
+            _Stringref sr(s.data(), s.size());
+            for (std::size_t pos = 0; pos <= len + 1; ++pos) {
+                for (char_type c : set) {
+                    EXPECT_EQ(sr.find(c, pos), s.find(c, pos));
+                    EXPECT_EQ(sr.rfind(c, pos), s.rfind(c, pos));
+                }
+                EXPECT_EQ(sr.find_first_of(set, pos), s.find_first_of(set, pos));
+                EXPECT_EQ(sr.find_last_of(set, pos), s.find_last_of(set, pos));
+                EXPECT_EQ(sr.find_first_not_of(set, pos), s.find_first_not_of(set, pos));
+                EXPECT_EQ(sr.find_last_not_of(set, pos), s.find_last_not_of(set, pos));
+            }
+            EXPECT_EQ(sr.rfind(set[0]), s.rfind(set[0]));
+            EXPECT_EQ(sr.find_last_of(set), s.find_last_of(set));
+            EXPECT_EQ(sr.find_last_not_of(set), s.find_last_not_of(set));
+        }
+    }
+}
+
+TEST(Common, FindChar)
+{
+    using namespace mg;
+    std::string str("abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ~!@#$%^&*()_+xyz");
+    std::u16string ustr(u"abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ~!@#$%^&*()_+xyz");
+    std::wstring wstr(L"abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ~!@#$%^&*()_+xyz");
+
+    CheckFind<stringref>(str, "a");
+    CheckFind<stringref>(str, "z+");
+    CheckFind<stringref>(str, "0123456789abcdefz");
+    CheckFind<stringref>(std::string(70, 'x') + "y", "x");
+    // Large sets of bytes are looked up in a table, bytes above 0x7F included.
+    CheckFind<stringref>(str + "\xE9\xFF" + str, "abcdefghijklmnopqrstuvwxyz\xFF");
+    CheckFind<ustringref>(ustr, u"a");
+    CheckFind<ustringref>(ustr, u"z+");
+    CheckFind<ustringref>(ustr, u"0123456789abcdefz");
+    CheckFind<ustringref>(std::u16string(70, u'x') + u"Ÿ", u"x");
+    CheckFind<ustringref>(std::u16string(70, u'Ÿ') + u"x", u"xŸ");
+    CheckFind<wstringref>(wstr, L"a");
+    CheckFind<wstringref>(wstr, L"0123456789abcdefz");
+
+    std::string nstr(40, 'x');
+    nstr[35] = '\0';
+    stringref s(nstr.data(), nstr.size());
+    EXPECT_EQ(s.find('\0'), static_cast<std::size_t>(35));
+    EXPECT_EQ(s.find_first_of(std::string(1, '\0')), static_cast<std::size_t>(35));
+    EXPECT_EQ(s.find_first_not_of("x"), static_cast<std::size_t>(35));
+    EXPECT_EQ(s.find_first_not_of("x", 0, 2), stringref::npos);
+    EXPECT_EQ(s.find_first_not_of(stringref_literal("x")), static_cast<std::size_t>(35));
+    EXPECT_EQ(s.find_first_not_of(stringref("x")), static_cast<std::size_t>(35));
+    EXPECT_EQ(s.find_first_of(""), stringref::npos);
+    EXPECT_EQ(s.find_first_not_of("", 3), static_cast<std::size_t>(3));
+    EXPECT_EQ(s.find_last_not_of(""), static_cast<std::size_t>(39));
+    EXPECT_TRUE(s.contains('x'));
+    EXPECT_FALSE(s.contains('y'));
+    EXPECT_FALSE(stringref().contains('x'));
+    EXPECT_EQ(stringref().find('x'), stringref::npos);
+    EXPECT_EQ(stringref().rfind('x'), stringref::npos);
+    EXPECT_EQ(stringref().find_last_not_of("x"), stringref::npos);
+}
+
+TEST(Common, FindCharCaseInsensitive)
+{
+    using namespace mg;
+    cistringref s("Test string, which is long enough to be searched with vector registers");
+    EXPECT_EQ(s.find('S'), static_cast<std::size_t>(2));
+    EXPECT_EQ(s.rfind('S'), static_cast<std::size_t>(69));
+    EXPECT_EQ(s.find_first_of("WG"), static_cast<std::size_t>(10));
+    EXPECT_EQ(s.find_last_of("WG"), static_cast<std::size_t>(63));
+    EXPECT_EQ(s.find_first_not_of("TES"), static_cast<std::size_t>(4));
+    EXPECT_EQ(s.find_last_not_of("SR"), static_cast<std::size_t>(67));
+    EXPECT_TRUE(s.contains('V'));
+}
+
+namespace {
+    template<typename _Stringref>
+    void CheckFindString(const std::basic_string<typename _Stringref::value_type>& str,
+                         const std::basic_string<typename _Stringref::value_type>& needle)
+    {
+        _Stringref sr(str.data(), str.size());
+        for (std::size_t pos = 0; pos <= str.size() + 1; ++pos) {
+            EXPECT_EQ(sr.find(needle, pos), str.find(needle, pos));
+        }
+    }
+
+    template<typename _Stringref>
+    void CheckFindStringRandom(unsigned seed)
+    {
+        typedef std::basic_string<typename _Stringref::value_type> string_type;
+        std::minstd_rand rnd(seed);
+        for (int iter = 0; iter < 200; ++iter) {
+            // Small alphabet makes partial matches frequent.
+            string_type str;
+            std::size_t len = rnd() % 200;
+            for (std::size_t i = 0; i < len; ++i) {
+                str.push_back(static_cast<typename _Stringref::value_type>('a' + rnd() % 3));
+            }
+            for (std::size_t m = 0; m <= 40; m += 1 + m / 8) {
+                string_type needle;
+                if ((m <= len) && (0 != (rnd() % 2))) {
+                    needle = str.substr(rnd() % (len - m + 1), m);
+                } else {
+                    for (std::size_t i = 0; i < m; ++i) {
+                        needle.push_back(static_cast<typename _Stringref::value_type>('a' + rnd() % 3));
+                    }
+                }
+                CheckFindString<_Stringref>(str, needle);
+            }
+        }
+    }
+}
+
+TEST(Common, FindString)
+{
+    using namespace mg;
+    CheckFindStringRandom<stringref>(1);
+    CheckFindStringRandom<ustringref>(2);
+    CheckFindStringRandom<wstringref>(3);
+
+    std::string str("Test string, which is long enough to be searched with vector registers");
+    CheckFindString<stringref>(str, "");
+    CheckFindString<stringref>(str, "s");
+    CheckFindString<stringref>(str, "st");
+    CheckFindString<stringref>(str, "string");
+    CheckFindString<stringref>(str, "registers");
+    CheckFindString<stringref>(str, "vector registers!");
+    CheckFindString<stringref>(str, str);
+
+    stringref s(str.data(), str.size());
+    EXPECT_EQ(s.find(stringref_literal("with")), static_cast<std::size_t>(49));
+    EXPECT_EQ(s.find(stringref("with")), static_cast<std::size_t>(49));
+    EXPECT_EQ(s.find("with", 50), stringref::npos);
+    EXPECT_EQ(s.find("with vector", 0, 4), static_cast<std::size_t>(49));
+    EXPECT_TRUE(s.contains("long"));
+    EXPECT_TRUE(s.contains(std::string("enough")));
+    EXPECT_FALSE(s.contains(stringref_literal("short")));
+    EXPECT_TRUE(stringref().contains(""));
+    EXPECT_FALSE(stringref().contains("x"));
+}
+
+TEST(Common, FindStringAdversarial)
+{
+    using namespace mg;
+    // Every position matches the first and the last characters of the needle.
+    std::string str(100000, 'a');
+    std::string needle = std::string(30, 'a') + "b" + std::string(29, 'a');
+    stringref s(str.data(), str.size());
+    EXPECT_EQ(s.find(needle), stringref::npos);
+    str[70000] = 'b';
+    s.assign(str.data(), str.size());
+    EXPECT_EQ(s.find(needle), static_cast<std::size_t>(70000 - 30));
+
+    str.assign(100000, 'a');
+    str += 'b';
+    needle = std::string(59, 'a') + "b";
+    s.assign(str.data(), str.size());
+    EXPECT_EQ(s.find(needle), str.size() - 60);
+
+    // Rare character of the needle is at every other position, candidates match all but the last character.
+    str.clear();
+    needle.clear();
+    for (std::size_t i = 0; i < 50000; ++i) {
+        str += "ab";
+    }
+    for (std::size_t i = 0; i < 30; ++i) {
+        needle += "ab";
+    }
+    needle += 'b';
+    s.assign(str.data(), str.size());
+    EXPECT_EQ(s.find(needle), stringref::npos);
+    str += needle;
+    s.assign(str.data(), str.size());
+    EXPECT_EQ(s.find(needle), str.size() - needle.size());
+
+    std::u16string ustr(100000, u'a');
+    ustr += u'b';
+    std::u16string uneedle = std::u16string(59, u'a') + u"b";
+    ustringref us(ustr.data(), ustr.size());
+    EXPECT_EQ(us.find(uneedle), ustr.size() - 60);
+    EXPECT_EQ(us.find(uneedle.substr(1) + u"a"), ustringref::npos);
+}
+
+TEST(Common, FindStringCaseInsensitive)
+{
+    using namespace mg;
+    cistringref s("Test string, which is long enough to be searched with vector registers");
+    EXPECT_EQ(s.find("STRING"), static_cast<std::size_t>(5));
+    EXPECT_EQ(s.find("Vector Registers"), static_cast<std::size_t>(54));
+    EXPECT_EQ(s.find("VECTOR REGISTERS!"), cistringref::npos);
+    EXPECT_TRUE(s.contains("WHICH IS"));
+}
+
+namespace {
+    template<typename _Searcher>
+    void CheckSearcherRandom(unsigned seed)
+    {
+        typedef typename _Searcher::value_type char_type;
+        typedef std::basic_string<char_type> string_type;
+        typedef typename _Searcher::stringref_type stringref_type;
+        std::minstd_rand rnd(seed);
+        for (int iter = 0; iter < 100; ++iter) {
+            string_type needle;
+            std::size_t m = rnd() % 40;
+            for (std::size_t i = 0; i < m; ++i) {
+                needle.push_back(static_cast<char_type>('a' + rnd() % 3));
+            }
+            _Searcher searcher(stringref_type(needle.data(), needle.size()));
+            needle[0] = 'x';
+            needle.assign(searcher.needle().data(), searcher.needle().size());
+            for (int h = 0; h < 10; ++h) {
+                string_type str;
+                std::size_t len = rnd() % 300;
+                for (std::size_t i = 0; i < len; ++i) {
+                    str.push_back(static_cast<char_type>('a' + rnd() % 3));
+                }
+                stringref_type sr(str.data(), str.size());
+                EXPECT_EQ(searcher(sr), str.find(needle));
+                EXPECT_EQ(searcher(str), str.find(needle));
+                std::size_t pos = rnd() % (len + 2);
+                EXPECT_EQ(searcher.find(sr, pos), str.find(needle, pos));
+            }
+        }
+    }
+}
+
+TEST(Common, Searcher)
+{
+    using namespace mg;
+    CheckSearcherRandom<stringref_searcher>(1);
+    CheckSearcherRandom<ustringref_searcher>(2);
+    CheckSearcherRandom<wstringref_searcher>(3);
+
+    stringref_searcher searcher(stringref("registers"));
+    EXPECT_EQ(searcher.needle(), "registers");
+    EXPECT_TRUE(searcher.needle().is_detached());
+    EXPECT_EQ(searcher(stringref("Test string, which is long enough to be searched with vector registers")),
+              static_cast<std::size_t>(61));
+    EXPECT_EQ(searcher(std::string("Test string")), stringref::npos);
+
+    std::string str(100000, 'a');
+    stringref_searcher adversarial(stringref(std::string(30, 'a') + "b" + std::string(29, 'a'), stringref::detached));
+    EXPECT_EQ(adversarial(str), stringref::npos);
+    str[70000] = 'b';
+    EXPECT_EQ(adversarial(str), static_cast<std::size_t>(70000 - 30));
+}
+
+TEST(Common, SearcherCaseInsensitive)
+{
+    using namespace mg;
+    cistringref_searcher searcher(cistringref("Vector Registers"));
+    cistringref s("Test string, which is long enough to be searched with VECTOR registers");
+    EXPECT_EQ(searcher(s), static_cast<std::size_t>(54));
+    EXPECT_EQ(searcher(stringref("vector REGISTERS")), static_cast<std::size_t>(0));
+    EXPECT_EQ(searcher(stringref("vector REGISTER")), cistringref::npos);
+    EXPECT_EQ(searcher.find(s, 55), cistringref::npos);
+
+    cistringref_searcher short_searcher(cistringref("WH"));
+    EXPECT_EQ(short_searcher(s), static_cast<std::size_t>(13));
+    EXPECT_EQ(short_searcher.find(s, 14), cistringref::npos);
+}
+
+namespace {
+    // Traits without __int_fold(), all digits are equal.
+    struct digit_char_traits : public std::char_traits<char> {
+        static char __int_class(char c)
+        {
+            return ((c >= '0') && (c <= '9')) ? '0' : c;
+        }
+
+        static bool eq(char c1, char c2)
+        {
+            return __int_class(c1) == __int_class(c2);
+        }
+
+        static bool lt(char c1, char c2)
+        {
+            return static_cast<unsigned char>(__int_class(c1)) < static_cast<unsigned char>(__int_class(c2));
+        }
+
+        static int compare(const char* s1, const char* s2, std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i) {
+                if (lt(s1[i], s2[i])) {
+                    return -1;
+                }
+                if (lt(s2[i], s1[i])) {
+                    return 1;
+                }
+            }
+            return 0;
+        }
+
+        static const char* find(const char* s, std::size_t n, char c)
+        {
+            for (std::size_t i = 0; i < n; ++i) {
+                if (eq(s[i], c)) {
+                    return s + i;
+                }
+            }
+            return nullptr;
+        }
+    };
+}
+
+TEST(Common, SearcherCustomTraits)
+{
+    using namespace mg;
+    typedef basic_stringref<char, digit_char_traits> digitstringref;
+    basic_stringref_searcher<char, digit_char_traits> searcher(digitstringref("order 1234 of 56"));
+    digitstringref s("Test string with order 1111 of 99 and order 9876 of 54");
+    EXPECT_EQ(searcher(s), static_cast<std::size_t>(17));
+    EXPECT_EQ(searcher.find(s, 18), static_cast<std::size_t>(38));
+    EXPECT_EQ(searcher(digitstringref("order 123 of 56")), digitstringref::npos);
+}
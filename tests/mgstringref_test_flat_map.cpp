@@ -0,0 +1,209 @@
+#include "mgstringref_test.h"
+#include "mgstringref_flat_map.h"
+
+#include <map>
+#include <stdexcept>
+
+namespace {
+    // Allocator, which gives copies of containers another buffer.
+    template<typename T>
+    class copy_elsewhere_allocator : public inplace::allocator<T>
+    {
+    public:
+        copy_elsewhere_allocator(const inplace::allocator<T>& a, const inplace::allocator<T>& copies) :
+            inplace::allocator<T>(a),
+            copies_(copies)
+        {}
+
+        template<typename U>
+        copy_elsewhere_allocator(const copy_elsewhere_allocator<U>& other) :
+            inplace::allocator<T>(other),
+            copies_(other.copies_)
+        {}
+
+        copy_elsewhere_allocator select_on_container_copy_construction() const
+        {
+            return copy_elsewhere_allocator(copies_, copies_);
+        }
+
+        inplace::allocator<T> copies_;
+    };
+}
+
+TEST(Common, FlatMap)
+{
+    using namespace mg;
+    stringref_flat_map<int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find("missing"), map.end());
+    EXPECT_EQ(map.begin(), map.end());
+
+    std::string key("a key, which is longer than the inline buffer");
+    EXPECT_TRUE(map.try_emplace(stringref(key.data(), key.size()), 1).second);
+    EXPECT_FALSE(map.try_emplace(key, 2).second);
+    map["short"] = 3;
+    map[std::string("other")] = 4;
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(3));
+
+    // Keys are detached.
+    key[0] = 'A';
+    EXPECT_FALSE(map.contains(key));
+    key[0] = 'a';
+    EXPECT_EQ(map.at(key), 1);
+    EXPECT_TRUE(map.find(key)->first.is_detached());
+    EXPECT_NE(map.find(key)->first.data(), key.data());
+
+    // Lookups by all kinds of strings.
+    EXPECT_EQ(map.at("short"), 3);
+    EXPECT_EQ(map.at("short"_sr), 3);
+    EXPECT_EQ(map.at(std::string("short")), 3);
+    EXPECT_EQ(map.at(stringref("short")), 3);
+    EXPECT_EQ(map.at(cistringref("other")), 4);
+    EXPECT_FALSE(map.contains(cistringref("OTHER")));
+    EXPECT_EQ(map.count(static_cast<const char*>("other")), static_cast<std::size_t>(1));
+    EXPECT_EQ(map.count(""), static_cast<std::size_t>(0));
+    EXPECT_THROW(map.at("none"), std::out_of_range);
+
+    map[""] = 5;
+    EXPECT_EQ(map.at(stringref()), 5);
+    EXPECT_EQ(map.erase(""), static_cast<std::size_t>(1));
+    EXPECT_EQ(map.erase(""), static_cast<std::size_t>(0));
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(3));
+
+    int sum = 0;
+    for (const stringref_flat_map<int>::value_type& value : map) {
+        sum += value.second;
+    }
+    EXPECT_EQ(sum, 8);
+
+    const stringref_flat_map<int>& cmap = map;
+    EXPECT_EQ(cmap.find("other")->second, 4);
+    EXPECT_EQ(cmap.find("none"), cmap.end());
+
+    stringref_flat_map<int> copy(map);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains("short"));
+    EXPECT_EQ(copy.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(copy.at("short"), 3);
+
+    stringref_flat_map<int> moved(std::move(copy));
+    EXPECT_EQ(moved.at("other"), 4);
+    map = moved;
+    EXPECT_EQ(map.at(key), 1);
+    map.insert(stringref_flat_map<int>::value_type("inserted", 6));
+    EXPECT_EQ(map.at("inserted"), 6);
+}
+
+TEST(Common, FlatMapGrowth)
+{
+    using namespace mg;
+    stringref_flat_map<std::size_t> map;
+    std::map<std::string, std::size_t> expected;
+    const std::size_t count = 5000;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string key = "key-" + std::to_string(i * 7919) + ((i % 3) ? "" : "-with-a-long-enough-suffix");
+        map[key] = i;
+        expected[key] = i;
+    }
+    EXPECT_EQ(map.size(), count);
+    EXPECT_GE(map.bucket_count() - map.bucket_count() / 8, count);
+    for (const std::pair<const std::string, std::size_t>& e : expected) {
+        ASSERT_TRUE(map.contains(e.first));
+        EXPECT_EQ(map.at(e.first), e.second);
+    }
+
+    // Erase every other key, then insert them again, reusing deleted slots.
+    std::size_t erased = 0;
+    for (const std::pair<const std::string, std::size_t>& e : expected) {
+        if (0 == e.second % 2) {
+            erased += map.erase(e.first);
+        }
+    }
+    EXPECT_EQ(erased, (count + 1) / 2);
+    EXPECT_EQ(map.size(), count - erased);
+    for (const std::pair<const std::string, std::size_t>& e : expected) {
+        EXPECT_EQ(map.contains(e.first), (0 != e.second % 2));
+    }
+    std::size_t visited = 0;
+    for (stringref_flat_map<std::size_t>::iterator it = map.begin(); it != map.end(); ) {
+        EXPECT_EQ(it->second % 2, static_cast<std::size_t>(1));
+        ++visited;
+        it = (0 == it->second % 4) ? map.erase(it) : std::next(it);
+    }
+    EXPECT_EQ(visited, count - erased);
+    for (const std::pair<const std::string, std::size_t>& e : expected) {
+        map[e.first] = e.second;
+    }
+    EXPECT_EQ(map.size(), count);
+    for (const std::pair<const std::string, std::size_t>& e : expected) {
+        EXPECT_EQ(map.at(e.first), e.second);
+    }
+    map.reserve(count * 2);
+    EXPECT_GE(map.bucket_count() - map.bucket_count() / 8, count * 2);
+    EXPECT_EQ(map.at(expected.begin()->first), expected.begin()->second);
+}
+
+TEST(Common, FlatMapCaseInsensitive)
+{
+    using namespace mg;
+    cistringref_flat_map<int> map;
+    map["Content-Type"] = 1;
+    map["content-length"] = 2;
+    EXPECT_EQ(map.at("CONTENT-TYPE"), 1);
+    EXPECT_EQ(map.at(std::string("Content-Length")), 2);
+    EXPECT_EQ(map.at(stringref("content-type")), 1);
+    EXPECT_FALSE(map.try_emplace("CONTENT-TYPE", 3).second);
+    EXPECT_EQ(map.find("content-TYPE")->first, "Content-Type");
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(2));
+
+    wstringref_flat_map<int> wmap;
+    wmap[L"wide"] = 1;
+    EXPECT_EQ(wmap.at(std::wstring(L"wide")), 1);
+}
+
+TEST_F(CustomAllocator, FlatMap)
+{
+    using namespace inplace;
+    typedef mg::basic_stringref_flat_map<int, char, std::char_traits<char>, ::inplace::allocator<char> > map_type;
+    {
+        map_type map(a);
+        std::string key("a key, which is longer than the inline buffer");
+        map[key] = 1;
+        map["short"] = 2;
+        // Control bytes, slots and the detached long key.
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(3));
+        EXPECT_EQ(map.at(stringref(key.data(), key.size(), a)), 1);
+        EXPECT_EQ(map.at("short"), 2);
+        map_type copy(map);
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(5));
+        EXPECT_EQ(copy.at(key), 1);
+    }
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+}
+
+TEST_F(CustomAllocator, FlatMapCopyAllocator)
+{
+    typedef copy_elsewhere_allocator<char> allocator_type;
+    typedef mg::basic_stringref_flat_map<int, char, std::char_traits<char>, allocator_type> map_type;
+    {
+        map_type map(allocator_type(a, a2));
+        map["a key, which is longer than the inline buffer"] = 1;
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(3));
+
+        // Copy allocates control bytes and slots with the selected allocator, the key selects it as well.
+        map_type copy(map);
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(3));
+        EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(3));
+        EXPECT_EQ(copy.at("a key, which is longer than the inline buffer"), 1);
+
+        // Allocator is not propagated on copy assignment.
+        map_type assigned(allocator_type(a, a));
+        assigned = copy;
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(5));
+        EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(3));
+        EXPECT_EQ(assigned.at("a key, which is longer than the inline buffer"), 1);
+    }
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(0));
+}
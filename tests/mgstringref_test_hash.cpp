@@ -0,0 +1,120 @@
+#include "mgstringref_test.h"
+
+#include <set>
+#include <unordered_map>
+
+TEST(Common, Hash)
+{
+    using namespace mg;
+    std::string str("Hash of the string does not depend on the way the string is stored");
+    stringref ref(str.data(), str.size());
+    stringref detached(str, stringref::detached);
+    stringref adopted{std::string(str)};
+    EXPECT_EQ(ref.hash(), detached.hash());
+    EXPECT_EQ(ref.hash(), adopted.hash());
+    EXPECT_EQ(ref.hash(), std::hash<stringref>()(ref));
+
+    // Substrings of every length, stored in every mode.
+    std::set<std::size_t> hashes;
+    for (std::size_t n = 0; n <= str.size(); ++n) {
+        stringref sub(detached, 0, n);
+        stringref sub_ref(str.data(), n);
+        stringref sub_detached(str.data(), n, stringref::detached);
+        EXPECT_EQ(sub.hash(), sub_ref.hash());
+        EXPECT_EQ(sub.hash(), sub_detached.hash());
+        hashes.insert(sub.hash());
+    }
+    EXPECT_EQ(hashes.size(), str.size() + 1);
+
+    ustringref u(u"Hash of UTF-16 string");
+    EXPECT_EQ(u.hash(), ustringref(u"Hash of UTF-16 string", ustringref::detached).hash());
+    EXPECT_NE(u.hash(), ustringref(u"hash of UTF-16 string").hash());
+}
+
+TEST(Common, HashCaseInsensitive)
+{
+    using namespace mg;
+    EXPECT_EQ(cistringref("Content-Length").hash(), cistringref("CONTENT-LENGTH").hash());
+    EXPECT_NE(cistringref("Content-Length").hash(), cistringref("Content-Type").hash());
+    EXPECT_EQ(asciicistringref("Content-Length").hash(), asciicistringref("content-length").hash());
+    EXPECT_EQ(ciwstringref(L"Привет").hash(), ciwstringref(L"пРИВЕТ").hash());
+    EXPECT_EQ(ciustringref(u"Σοφία").hash(), ciustringref(u"ΣΟΦΊΑ").hash());
+
+    // Long strings are folded by chunks.
+    std::string upper(1000, 'A');
+    std::string lower(1000, 'a');
+    upper[700] = 'Z';
+    lower[700] = 'z';
+    EXPECT_EQ(cistringref(upper).hash(), cistringref(lower).hash());
+    lower[999] = 'b';
+    EXPECT_NE(cistringref(upper).hash(), cistringref(lower).hash());
+
+    std::unordered_map<cistringref, int> headers;
+    headers[cistringref("Host")] = 1;
+    headers[cistringref("Accept")] = 2;
+    EXPECT_EQ(headers.size(), static_cast<std::size_t>(2));
+    EXPECT_EQ(headers[cistringref("HOST")], 1);
+    EXPECT_EQ(headers.count(cistringref("accept")), static_cast<std::size_t>(1));
+}
+
+TEST_F(StandardAllocator, UnorderedMap)
+{
+    std::unordered_map<mg::stringref, int> map;
+    for (int i = 0; i < 1000; ++i) {
+        map.emplace(mg::stringref(std::to_string(i), mg::stringref::detached), i);
+    }
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(1000));
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = std::to_string(i);
+        auto it = map.find(mg::stringref(key));
+        ASSERT_NE(it, map.end());
+        EXPECT_EQ(it->second, i);
+    }
+    EXPECT_EQ(map.find(mg::stringref("1000")), map.end());
+}
+
+TEST_F(CustomAllocator, HashCached)
+{
+    using namespace inplace;
+    stringref s("String, which is long enough to have the hash cached in its data block", stringref::detached, a);
+    const std::size_t h = s.hash();
+    EXPECT_NE(h, static_cast<std::size_t>(0));
+    EXPECT_EQ(h, s.hash());
+    stringref copy(s);
+    EXPECT_EQ(h, copy.hash());
+    EXPECT_EQ(h, stringref(s.data(), s.size(), a).hash());
+
+    // Substring of the block is not cached.
+    stringref sub(s, 1, s.size() - 1);
+    EXPECT_EQ(sub.hash(), stringref(s.data() + 1, s.size() - 1, a).hash());
+
+    // Reused block gets a new hash.
+    copy.assign(stringref(a));
+    sub.assign(stringref(a));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+    s.assign("String, which is long enough to have the hash cached in its data BLOCK", stringref::detached);
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_NE(h, s.hash());
+    EXPECT_EQ(s.hash(), stringref(s.data(), s.size(), a).hash());
+
+    // Case-insensitive hash does not use the hash of the shared block.
+    cistringref ci(s);
+    EXPECT_EQ(ci.hash(),
+              cistringref("STRING, WHICH IS LONG ENOUGH TO HAVE THE HASH CACHED IN ITS DATA BLOCK", a).hash());
+    EXPECT_EQ(s.hash(), stringref(s.data(), s.size(), a).hash());
+}
+
+TEST_F(CustomAllocator, HashNotCached)
+{
+    using namespace inplace;
+    // Block is too short to have the hash cache, the hash is computed on demand.
+    stringref s("String, which is stored in a data block", stringref::detached, a);
+    const std::size_t h = s.hash();
+    EXPECT_EQ(h, s.hash());
+    EXPECT_EQ(h, stringref(s).hash());
+    EXPECT_EQ(h, stringref(s.data(), s.size(), a).hash());
+    s.assign("String, which is stored in a data BLOCK", stringref::detached);
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_NE(h, s.hash());
+    EXPECT_EQ(s.hash(), stringref(s.data(), s.size(), a).hash());
+}
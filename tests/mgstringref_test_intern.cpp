@@ -0,0 +1,115 @@
+#include "mgstringref_test.h"
+#include "mgstringref_intern.h"
+
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+TEST(Common, InternPool)
+{
+    using namespace mg;
+    stringref_intern_pool pool;
+    std::string name("http.server.requests.duration");
+    interned_stringref i1 = pool.intern(name);
+    interned_stringref i2 = pool.intern(stringref(name.data(), name.size()));
+    interned_stringref i3 = pool.intern(std::string("http.server.requests.count"));
+    EXPECT_EQ(i1, i2);
+    EXPECT_NE(i1, i3);
+    EXPECT_EQ(i1.hash(), i2.hash());
+    EXPECT_EQ(i1.str(), name.c_str());
+    EXPECT_EQ(i1.size(), name.size());
+    EXPECT_EQ(i1.data(), i2.data());
+    EXPECT_NE(i1.data(), name.data());
+    EXPECT_EQ(pool.size(), static_cast<stringref_intern_pool::size_type>(2));
+
+    // Canonical strings are detached, copies share the data block.
+    stringref copy = i1.str();
+    EXPECT_TRUE(copy.is_detached());
+    EXPECT_EQ(copy.data(), i1.data());
+    name[0] = 'H';
+    EXPECT_EQ(i1.str(), "http.server.requests.duration");
+
+    // Short strings are stored inline in the pool entry.
+    interned_stringref s1 = pool.intern("id"_sr);
+    interned_stringref s2 = pool.intern(std::string("id"));
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(s1.data(), s2.data());
+
+    interned_stringref null;
+    interned_stringref empty = pool.intern(std::string());
+    EXPECT_TRUE(null.is_null());
+    EXPECT_TRUE(null.empty());
+    EXPECT_FALSE(empty.is_null());
+    EXPECT_TRUE(empty.empty());
+    EXPECT_NE(null, empty);
+    EXPECT_EQ(empty, pool.intern(""_sr));
+    EXPECT_EQ(empty.str(), "");
+    EXPECT_EQ(null.size(), static_cast<std::size_t>(0));
+    EXPECT_EQ(pool.size(), static_cast<stringref_intern_pool::size_type>(3));
+
+    std::unordered_map<interned_stringref, int> counters;
+    ++counters[i1];
+    ++counters[i2];
+    ++counters[i3];
+    EXPECT_EQ(counters[pool.intern("http.server.requests.duration"_sr)], 2);
+    EXPECT_EQ(counters[i3], 1);
+
+    wstringref_intern_pool wpool;
+    EXPECT_EQ(wpool.intern(std::wstring(L"tenant-0001")), wpool.intern(wstringref(L"tenant-0001")));
+}
+
+TEST(Common, InternPoolThreads)
+{
+    using namespace mg;
+    stringref_intern_pool pool;
+    const int thread_count = 8;
+    const int key_count = 2000;
+    std::vector<std::vector<interned_stringref> > results(thread_count);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&pool, &results, t, key_count]() {
+            for (int i = 0; i < key_count; ++i) {
+                // Threads intern the same keys in different order.
+                int k = (i * 7 + t * 131) % key_count;
+                std::string key = "tenant-" + std::to_string(k) + "-with-a-long-enough-name";
+                results[t].push_back(pool.intern(key));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(pool.size(), static_cast<stringref_intern_pool::size_type>(key_count));
+    for (int t = 1; t < thread_count; ++t) {
+        for (int i = 0; i < key_count; ++i) {
+            int k = (i * 7 + t * 131) % key_count;
+            int i0 = 0;
+            while ((i0 * 7) % key_count != k) {
+                ++i0;
+            }
+            EXPECT_EQ(results[t][i], results[0][i0]);
+        }
+    }
+}
+
+TEST_F(CustomAllocator, InternPool)
+{
+    using namespace inplace;
+    typedef mg::basic_stringref_intern_pool<char, std::char_traits<char>, ::inplace::allocator<char> > pool_type;
+    {
+        pool_type pool(a);
+        std::string key("metric.name.which.needs.a.data.block");
+        for (int i = 0; i < 10; ++i) {
+            pool.intern(key);
+        }
+        pool.intern(std::string("metric.name.which.needs.another.block"));
+        pool.intern(std::string("short"));
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+
+        stringref shared(pool.intern(key).str());
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(2));
+        EXPECT_EQ(shared, key.c_str());
+    }
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+}
@@ -0,0 +1,71 @@
+#include "mgstringref_test.h"
+
+namespace {
+    using namespace mg::literals;
+
+    constexpr mg::stringref::literal methods[] = {"GET", "HEAD", "POST", "PUT", "DELETE"};
+    constexpr mg::stringref_literal get = "GET"_sr;
+    constexpr mg::ustringref_literal uget = u"GET"_sr;
+    constexpr mg::wstringref_literal wget = L"GET"_sr;
+
+    static_assert(3 == methods[0].size(), "Invalid literal size.");
+    static_assert(6 == methods[4].size(), "Invalid literal size.");
+    static_assert(3 == get.size(), "Invalid literal size.");
+    static_assert(3 == uget.size(), "Invalid literal size.");
+    static_assert(3 == wget.size(), "Invalid literal size.");
+    static_assert('P' == methods[3][0], "Invalid literal data.");
+    static_assert(methods[0] == get, "Invalid literal comparison.");
+    static_assert(methods[1] != get, "Invalid literal comparison.");
+    static_assert(4 == "a\0bc"_sr.size(), "Invalid literal size.");
+
+    constexpr std::size_t find_method(const mg::stringref_literal& method, std::size_t index = 0)
+    {
+        return (index == (sizeof(methods) / sizeof(methods[0]))) ? index
+               : (methods[index] == method) ? index : find_method(method, index + 1);
+    }
+    static_assert(2 == find_method("POST"_sr), "Invalid constexpr lookup.");
+}
+
+TEST(Common, Literals)
+{
+    using namespace mg;
+
+    stringref s1(methods[2]);
+    EXPECT_FALSE(s1.is_detached());
+    EXPECT_EQ(s1.data(), methods[2].data());
+    EXPECT_EQ(s1.size(), static_cast<std::size_t>(4));
+    EXPECT_EQ(s1, "POST");
+    EXPECT_EQ(s1, "POST"_sr);
+    EXPECT_TRUE("POST"_sr == s1);
+    EXPECT_NE(s1, get);
+    EXPECT_LT(s1, "PUT"_sr);
+
+    stringref s2("GET"_sr, stringref::detached);
+    ustringref us2(uget);
+    wstringref ws2(wget, wstringref::detached);
+    EXPECT_TRUE(s2.is_detached());
+    EXPECT_FALSE(us2.is_detached());
+    EXPECT_TRUE(ws2.is_detached());
+    EXPECT_EQ(s2, "GET");
+    EXPECT_EQ(us2, u"GET");
+    EXPECT_EQ(ws2, L"GET");
+
+    cistringref s3("get"_sr);
+    EXPECT_EQ(s3, "GET"_sr);
+
+    s2.assign(methods[4]);
+    EXPECT_FALSE(s2.is_detached());
+    EXPECT_EQ(s2, "DELETE");
+    s2.assign(methods[1], stringref::detached);
+    EXPECT_TRUE(s2.is_detached());
+    EXPECT_EQ(s2, "HEAD");
+
+    std::size_t index = sizeof(methods) / sizeof(methods[0]);
+    stringref key("PUT", stringref::detached);
+    for (std::size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (key == methods[i]) {
+            index = i;
+        }
+    }
+    EXPECT_EQ(index, static_cast<std::size_t>(3));
+}
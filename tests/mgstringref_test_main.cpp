@@ -170,8 +170,8 @@ TEST_F(CustomAllocator, Detach)
     ws1.detach();
     ws2.detach();
     ws3.detach();
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
-    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(4));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(2));
     EXPECT_TRUE(s1.is_detached());
     EXPECT_TRUE(s2.is_detached());
     EXPECT_TRUE(s3.is_detached());
@@ -192,6 +192,76 @@ TEST_F(CustomAllocator, Detach)
     EXPECT_EQ(ws3, L"String");
 }
 
+TEST_F(CustomAllocator, CStr)
+{
+    using namespace inplace;
+    char str[] = "Test string, which is too long to be stored inline";
+
+    // Not owned string is copied into the buffer, or replaced with terminated copy.
+    stringref s1(str, a);
+    string buffer(a2);
+    EXPECT_EQ(s1.terminated_data(), nullptr);
+    EXPECT_STREQ(s1.c_str(buffer), str);
+    EXPECT_EQ(s1.c_str(buffer), buffer.data());
+    EXPECT_FALSE(s1.is_detached());
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+    EXPECT_STREQ(s1.c_str(), str);
+    EXPECT_NE(s1.c_str(), str);
+    EXPECT_EQ(s1.terminated_data(), s1.data());
+    EXPECT_TRUE(s1.is_detached());
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+
+    // Detached string and its suffix are returned as is.
+    stringref s2(str, stringref::detached, a);
+    const stringref s3(s2, 37, stringref::npos);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(s2.terminated_data(), s2.data());
+    EXPECT_EQ(s2.c_str(), s2.data());
+    EXPECT_EQ(s3.terminated_data(), s3.data());
+    EXPECT_EQ(s3.c_str(buffer), s3.data());
+    EXPECT_STREQ(s3.terminated_data(), "stored inline");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(2));
+
+    // Substring in the middle needs a copy, a short one is stored inline.
+    stringref s4(s2, 5, 20);
+    EXPECT_EQ(s4.terminated_data(), nullptr);
+    EXPECT_STREQ(s4.c_str(), "string, which is too");
+    EXPECT_NE(s4.data(), s2.data() + 5);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    stringref s9(s2, 5, 6);
+    EXPECT_STREQ(s9.c_str(), "string");
+    EXPECT_NE(s9.data(), s2.data() + 5);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+
+    // Reused data block is terminated too.
+    s4.assign("str", 2, stringref::detached);
+    EXPECT_EQ(s4.terminated_data(), s4.data());
+    EXPECT_STREQ(s4.c_str(), "st");
+    s4.assign(s2, stringref::detached);
+    s4.assign(s4, 13, 5, stringref::detached);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    EXPECT_STREQ(s4.terminated_data(), "which");
+
+    // Inline string has space for the terminator, unless it is full.
+    stringref s5("Short", stringref::detached, a);
+    stringref s6("Fifteen chars!!", stringref::detached, a);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(3));
+    EXPECT_EQ(s5.terminated_data(), s5.data());
+    EXPECT_STREQ(s5.c_str(), "Short");
+    EXPECT_EQ(s6.terminated_data(), nullptr);
+    EXPECT_STREQ(s6.c_str(), "Fifteen chars!!");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
+
+    // Reference to a literal is never null either.
+    stringref s7(a);
+    stringref s8("Literal", a);
+    EXPECT_STREQ(s7.terminated_data(), "");
+    EXPECT_STREQ(s7.c_str(), "");
+    EXPECT_EQ(s8.terminated_data(), nullptr);
+    EXPECT_STREQ(s8.c_str(), "Literal");
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(4));
+}
+
 TEST(Common, CiCharTraits)
 {
     using namespace mg;
@@ -234,6 +304,208 @@ TEST(Common, CiCharTraits)
     EXPECT_EQ(ci_char_traits<char>::find(test, 6, 'D'), nullptr);
 }
 
+TEST(Common, CiCharTraitsEqIntType)
+{
+    using namespace mg;
+    typedef ci_char_traits<char> traits;
+    for (unsigned c1 = 0; c1 < 256; ++c1) {
+        for (unsigned c2 = 0; c2 < 256; ++c2) {
+            const char ch1 = static_cast<char>(c1);
+            const char ch2 = static_cast<char>(c2);
+            EXPECT_EQ(traits::eq(ch1, ch2), traits::eq_int_type(traits::to_int_type(ch1), traits::to_int_type(ch2)));
+        }
+    }
+    EXPECT_TRUE(traits::eq_int_type(traits::eof(), traits::eof()));
+    EXPECT_FALSE(traits::eq_int_type(traits::eof(), traits::to_int_type('\xFF')));
+    EXPECT_FALSE(traits::eq_int_type(traits::to_int_type('\xFF'), traits::eof()));
+    EXPECT_FALSE(traits::eq_int_type(traits::to_int_type('a'), traits::eof()));
+}
+
+TEST(Common, CiCharTraitsCompare)
+{
+    using namespace mg;
+    typedef ci_char_traits<char> traits;
+    std::string s1("The Quick Brown Fox Jumps Over The Lazy Dog, 0123456789 [@`{] THE QUICK BROWN FOX JUMPS");
+    std::string s2(s1);
+    for (char& c : s2) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    for (std::size_t n = 0; n <= s1.size(); ++n) {
+        EXPECT_EQ(0, traits::compare(s1.data(), s2.data(), n));
+    }
+
+    // Difference at every position, both in vector blocks and in tails.
+    for (std::size_t i = 0; i < s1.size(); ++i) {
+        std::string s3(s2);
+        s3[i] = '~';
+        int expected = (std::toupper(static_cast<unsigned char>(s1[i])) < '~') ? -1 : 1;
+        EXPECT_EQ(expected, traits::compare(s1.data(), s3.data(), s1.size()));
+        EXPECT_EQ(-expected, traits::compare(s3.data(), s1.data(), s1.size()));
+        EXPECT_EQ(0, traits::compare(s1.data(), s3.data(), i));
+    }
+
+    // Characters around the letters must not be folded.
+    EXPECT_GT(0, traits::compare("@", "`", 1));
+    EXPECT_GT(0, traits::compare("[", "{", 1));
+    EXPECT_GT(0, traits::compare(std::string(40, '@').data(), std::string(40, '`').data(), 40));
+    EXPECT_LT(0, traits::compare(std::string(40, '{').data(), std::string(40, '[').data(), 40));
+
+    // Non-ASCII characters are compared with the locale.
+    std::string s4(s1);
+    std::string s5(s2);
+    s4[20] = static_cast<char>(0xE9);
+    s5[20] = static_cast<char>(0xE9);
+    EXPECT_EQ(0, traits::compare(s4.data(), s5.data(), s4.size()));
+    s5[50] = static_cast<char>(0xE9);
+    EXPECT_GT(0, traits::compare(s4.data(), s5.data(), s4.size()));
+
+    cistringref cs1(s1.data(), s1.size());
+    EXPECT_EQ(cs1, s2.c_str());
+    EXPECT_TRUE(cs1 < "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG, 0123456789 [@`{] THE QUICK BROWN FOX JUMPT");
+}
+
+namespace {
+    template<typename _Traits>
+    void CheckCiFind(const std::basic_string<typename _Traits::char_type>& str)
+    {
+        typedef typename _Traits::char_type char_type;
+        // Every target and every length, so matches are found both in vector blocks and in tails.
+        for (std::size_t t = 0; t < str.size(); ++t) {
+            const char_type c = str[t];
+            for (std::size_t n = 0; n <= str.size(); ++n) {
+                const char_type* expected = nullptr;
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (_Traits::eq(str[i], c)) {
+                        expected = str.data() + i;
+                        break;
+                    }
+                }
+                EXPECT_EQ(expected, _Traits::find(str.data(), n, c));
+            }
+        }
+    }
+}
+
+TEST(Common, CiCharTraitsFind)
+{
+    using namespace mg;
+    std::string s("the quick brown fox jumps over THE LAZY DOG, @[`{ 0123456789 ~ the quick brown fox jumps over");
+    CheckCiFind<ci_char_traits<char> >(s);
+    s[10] = static_cast<char>(0xE9);
+    s[40] = static_cast<char>(0xC9);
+    s[70] = static_cast<char>(0xFF);
+    CheckCiFind<ci_char_traits<char> >(s);
+    // Long enough for several blocks of four vectors.
+    CheckCiFind<ci_char_traits<char> >(s + s + s);
+
+    std::wstring ws(L"the quick brown fox jumps over THE LAZY DOG, @[`{ 0123456789 ~ the quick brown fox jumps");
+    CheckCiFind<ci_char_traits<wchar_t> >(ws);
+    ws[10] = static_cast<wchar_t>(0x0131);
+    ws[40] = static_cast<wchar_t>(0x017F);
+    ws[70] = static_cast<wchar_t>(0x00E9);
+    CheckCiFind<ci_char_traits<wchar_t> >(ws);
+
+    std::u16string us(u"the quick brown fox jumps over THE LAZY DOG, @[`{ 0123456789 ~ \u0416\u0436 the quick");
+    CheckCiFind<ci_char_traits<char16_t> >(us);
+    us[10] = static_cast<char16_t>(0x212A);
+    us[20] = static_cast<char16_t>(0xD801);
+    CheckCiFind<ci_char_traits<char16_t> >(us);
+
+    cistringref cs(s.data(), s.size());
+    EXPECT_EQ(cs.find('Z'), static_cast<std::size_t>(37));
+    EXPECT_EQ(cs.find('t', 1), static_cast<std::size_t>(31));
+    EXPECT_EQ(cs.find('!'), cistringref::npos);
+}
+
+TEST(Common, CiUnicodeCharTraits)
+{
+    using namespace mg;
+    typedef ci_char_traits<char16_t> traits;
+    EXPECT_TRUE(traits::eq(u'A', u'a'));
+    EXPECT_TRUE(traits::eq(u'\u0416', u'\u0436'));
+    EXPECT_TRUE(traits::eq(u'\u03A3', u'\u03C2'));
+    EXPECT_TRUE(traits::eq(u'\u03C3', u'\u03C2'));
+    EXPECT_TRUE(traits::eq(u'\u00B5', u'\u039C'));
+    EXPECT_TRUE(traits::eq(u'\u212A', u'k'));
+    EXPECT_TRUE(traits::eq(u'\u017F', u'S'));
+    EXPECT_TRUE(traits::eq(u'\u1E9E', u'\u00DF'));
+    EXPECT_TRUE(traits::eq(u'\uFF21', u'\uFF41'));
+    EXPECT_FALSE(traits::eq(u'\u0130', u'i'));
+    EXPECT_FALSE(traits::eq(u'@', u'`'));
+    EXPECT_TRUE(traits::eq_int_type(traits::eof(), traits::eof()));
+    EXPECT_FALSE(traits::eq_int_type(traits::eof(), u'\uFFFE'));
+    EXPECT_TRUE(traits::lt(u'\u0430', u'\u042F'));
+    EXPECT_EQ(0, traits::compare(u"\u0422\u0435\u0441\u0442 Test", u"\u0442\u0415\u0421\u0422 tEST", 9));
+    EXPECT_GT(0, traits::compare(u"\u0430\u0431\u0432", u"\u0410\u0411\u0413", 3));
+
+    // Folding is idempotent and keeps characters, which are not letters.
+    for (std::uint32_t c = 0; c <= 0xFFFF; ++c) {
+        EXPECT_EQ(__int_casefold(c), __int_casefold(__int_casefold(c)));
+    }
+    for (std::uint32_t c = '0'; c <= '9'; ++c) {
+        EXPECT_EQ(c, __int_casefold(c));
+    }
+
+    // Characters outside of the BMP are not folded.
+    EXPECT_TRUE(ci_char_traits<char32_t>::eq(U'\u0416', U'\u0436'));
+    EXPECT_FALSE(ci_char_traits<char32_t>::eq(U'\U00010400', U'\U00010428'));
+
+    ciustringref s1(u"\u041F\u0440\u0438\u0432\u0435\u0442, World");
+    EXPECT_EQ(s1, u"\u043F\u0420\u0418\u0412\u0415\u0422, wORLD");
+    EXPECT_EQ(s1.find(u"\u0412\u0415\u0422"), static_cast<std::size_t>(3));
+    EXPECT_EQ(s1.find(u'W'), static_cast<std::size_t>(8));
+    EXPECT_EQ(ciustringref_searcher(ciustringref(u"WORLD")).find(s1), static_cast<std::size_t>(8));
+
+    ciwstringref s2(L"\u0393\u03B5\u03B9\u03AC \u03C3\u03BF\u03C5");
+    EXPECT_EQ(s2, L"\u03B3\u0395\u0399\u0386 \u03A3\u039F\u03A5");
+}
+
+TEST(Common, AsciiCiCharTraits)
+{
+    using namespace mg;
+    typedef ascii_ci_char_traits<char> traits;
+    static_assert(traits::eq('a', 'A'), "eq must be constexpr");
+    static_assert(!traits::eq('@', '`'), "only letters are folded");
+    static_assert(traits::lt('a', 'B'), "lt must be constexpr");
+    static_assert(0 == traits::compare("Content-Length", "content-length", 14), "compare must be constexpr");
+    static_assert(0 > traits::compare("Content-Length", "CONTENT-TYPE", 14), "compare must be constexpr");
+    static_assert(basic_stringref_literal<char, traits>("HELO") == basic_stringref_literal<char, traits>("helo"),
+                  "literals must be compared at compile time");
+
+    // Letters are folded without the locale, other characters are compared as is.
+    for (int c1 = 0; c1 < 256; ++c1) {
+        for (int c2 = 0; c2 < 256; ++c2) {
+            const bool letters = (std::isalpha(c1) || std::isalpha(c2)) && (c1 < 0x80) && (c2 < 0x80);
+            const bool expected = letters ? (std::toupper(c1) == std::toupper(c2)) : (c1 == c2);
+            EXPECT_EQ(expected, traits::eq(static_cast<char>(c1), static_cast<char>(c2)));
+        }
+    }
+    EXPECT_FALSE(traits::eq(static_cast<char>(0xE9), static_cast<char>(0xC9)));
+    EXPECT_TRUE(traits::lt('z', static_cast<char>(0x80)));
+    EXPECT_TRUE(traits::eq_int_type(traits::to_int_type('x'), traits::to_int_type('X')));
+    EXPECT_FALSE(traits::eq_int_type(traits::eof(), traits::to_int_type(static_cast<char>(0xFF))));
+
+    std::string s1("Accept-Encoding: gzip, deflate, br; Accept-Language: en-US,en;q=0.9 [@`{] ~ ACCEPT");
+    std::string s2(s1);
+    for (char& c : s2) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    for (std::size_t i = 0; i < s1.size(); ++i) {
+        EXPECT_EQ(0, traits::compare(s1.data(), s2.data(), i));
+        std::string s3(s2);
+        s3[i] = static_cast<char>(0xE9);
+        EXPECT_GT(0, traits::compare(s1.data(), s3.data(), s1.size()));
+        EXPECT_LT(0, traits::compare(s3.data(), s1.data(), s1.size()));
+    }
+
+    asciicistringref h(s1.data(), s1.size());
+    EXPECT_EQ(h, s2.c_str());
+    EXPECT_EQ(h.find('G'), static_cast<std::size_t>(14));
+    EXPECT_EQ(h.find("accept-language"), static_cast<std::size_t>(36));
+    EXPECT_EQ(h.rfind('a'), static_cast<std::size_t>(s1.size() - 6));
+    EXPECT_EQ(ascii_ci_char_traits<wchar_t>::compare(L"Host", L"hOST", 4), 0);
+}
+
 TEST(Common, CiWCharTraits)
 {
     using namespace mg;
@@ -394,7 +666,7 @@ TEST_F(CustomAllocator, MoveAndCopyConstructWithOtherCharTraits)
 
     cistringref s06(stringref(std::string("Test string"), a), 5, 6);
     ciwstringref ws06(wstringref(std::wstring(L"Test string"), a2), 5, 6);
-    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
     EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
     EXPECT_EQ(s06, "STRING");
     EXPECT_EQ(ws06, L"STRING");
@@ -0,0 +1,130 @@
+#include "mgstringref_test.h"
+#include "mgstringref_matcher.h"
+
+#include <random>
+#include <vector>
+
+TEST(Common, Matcher)
+{
+    using namespace mg;
+    stringref_matcher matcher({stringref("he"), stringref("she"), stringref("his"), stringref("hers"),
+                               stringref(""), stringref("he")});
+    EXPECT_EQ(matcher.pattern_count(), static_cast<std::size_t>(6));
+    EXPECT_TRUE(matcher.pattern(1).is_detached());
+
+    std::vector<stringref_matcher::match> matches = matcher.find_all(stringref("ushers"));
+    ASSERT_EQ(matches.size(), static_cast<std::size_t>(4));
+    EXPECT_EQ(matches[0].text, "she");
+    EXPECT_EQ(matches[0].position, static_cast<std::size_t>(1));
+    EXPECT_EQ(matches[0].pattern, static_cast<std::size_t>(1));
+    EXPECT_EQ(matches[1].text, "he");
+    EXPECT_EQ(matches[1].position, static_cast<std::size_t>(2));
+    EXPECT_EQ(matches[2].text, "he");
+    EXPECT_EQ(matches[2].position, static_cast<std::size_t>(2));
+    EXPECT_NE(matches[1].pattern, matches[2].pattern);
+    EXPECT_EQ(matches[3].text, "hers");
+    EXPECT_EQ(matches[3].pattern, static_cast<std::size_t>(3));
+
+    EXPECT_TRUE(matcher.contains_any(stringref("this")));
+    EXPECT_FALSE(matcher.contains_any(stringref("nothing")));
+    EXPECT_FALSE(matcher.contains_any(stringref()));
+
+    int count = 0;
+    EXPECT_FALSE(matcher.scan(stringref("he he he"), [&count](const stringref_matcher::match&) {
+        return (++count < 3);
+    }));
+    EXPECT_EQ(count, 3);
+}
+
+TEST_F(CustomAllocator, MatcherSharesHaystack)
+{
+    using namespace inplace;
+    typedef mg::basic_stringref_matcher<char, std::char_traits<char>, ::inplace::allocator<char> > matcher_type;
+    std::vector<stringref> keywords;
+    keywords.push_back(stringref("error", a));
+    keywords.push_back(stringref("timeout", a));
+    matcher_type matcher(keywords.begin(), keywords.end());
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+
+    std::vector<matcher_type::match> matches;
+    {
+        stringref message("Connection error: read timeout after an error", stringref::detached, a2);
+        EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+        matches = matcher.find_all(message);
+    }
+    ASSERT_EQ(matches.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a2.alloc_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(matches[0].text, "error");
+    EXPECT_EQ(matches[1].text, "timeout");
+    EXPECT_EQ(matches[2].text, "error");
+    EXPECT_TRUE(matches[1].text.is_detached());
+    EXPECT_EQ(matches[1].text.data(), matches[0].text.data() + 12);
+
+    matches.clear();
+    EXPECT_EQ(a2.used_block_count(), static_cast<std::size_t>(0));
+}
+
+TEST(Common, MatcherRandom)
+{
+    using namespace mg;
+    std::minstd_rand rnd(1);
+    for (int iter = 0; iter < 50; ++iter) {
+        std::vector<std::u16string> keywords(1 + rnd() % 20);
+        std::vector<ustringref> patterns;
+        for (std::u16string& k : keywords) {
+            for (std::size_t len = 1 + rnd() % 5; 0 != len; --len) {
+                k.push_back(static_cast<char16_t>(u'a' + rnd() % 3));
+            }
+            patterns.push_back(ustringref(k.data(), k.size()));
+        }
+        ustringref_matcher matcher(patterns.begin(), patterns.end());
+
+        std::u16string str;
+        for (std::size_t len = rnd() % 200; 0 != len; --len) {
+            str.push_back(static_cast<char16_t>(u'a' + rnd() % 4));
+        }
+        std::vector<std::pair<std::size_t, std::size_t> > expected;
+        for (std::size_t end = 1; end <= str.size(); ++end) {
+            for (std::size_t k = keywords.size(); 0 != k--; ) {
+                const std::u16string& keyword = keywords[k];
+                if ((keyword.size() <= end) && (0 == str.compare(end - keyword.size(), keyword.size(), keyword))) {
+                    expected.push_back(std::make_pair(end - keyword.size(), k));
+                }
+            }
+        }
+        std::vector<std::pair<std::size_t, std::size_t> > actual;
+        matcher.scan(ustringref(str.data(), str.size()), [&actual](const ustringref_matcher::match& m) {
+            actual.push_back(std::make_pair(m.position, m.pattern));
+            return true;
+        });
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        EXPECT_EQ(actual, expected);
+    }
+}
+
+TEST(Common, MatcherCaseInsensitive)
+{
+    using namespace mg;
+    cistringref_matcher matcher({cistringref("Error"), cistringref("WARN")});
+    std::vector<cistringref_matcher::match> matches = matcher.find_all(cistringref("warn: ERROR, error"));
+    ASSERT_EQ(matches.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(matches[0].pattern, static_cast<std::size_t>(1));
+    EXPECT_EQ(matches[0].text, "WARN");
+    EXPECT_EQ(matches[1].position, static_cast<std::size_t>(6));
+    EXPECT_EQ(matches[2].position, static_cast<std::size_t>(13));
+}
+
+TEST(Common, MatcherAsciiCaseInsensitive)
+{
+    using namespace mg;
+    typedef basic_stringref_matcher<char, ascii_ci_char_traits<char> > matcher_type;
+    matcher_type matcher({asciicistringref("GET"), asciicistringref("Host:")});
+    std::vector<matcher_type::match> matches = matcher.find_all(asciicistringref("get / HTTP/1.1\r\nHOST: target"));
+    ASSERT_EQ(matches.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(matches[0].position, static_cast<std::size_t>(0));
+    EXPECT_EQ(matches[1].position, static_cast<std::size_t>(16));
+    EXPECT_EQ(matches[1].pattern, static_cast<std::size_t>(1));
+    EXPECT_EQ(matches[2].text, "get");
+}
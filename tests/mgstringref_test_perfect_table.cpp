@@ -0,0 +1,83 @@
+#include "mgstringref_test.h"
+#include "mgstringref_perfect_table.h"
+
+#include <stdexcept>
+#include <vector>
+
+TEST(Common, PerfectTable)
+{
+    using namespace mg;
+    stringref_perfect_table table({"GET"_sr, "HEAD"_sr, "POST"_sr, "PUT"_sr, "DELETE"_sr, "CONNECT"_sr, "OPTIONS"_sr,
+                                   "TRACE"_sr, "PATCH"_sr});
+    EXPECT_EQ(table.size(), static_cast<std::size_t>(9));
+    EXPECT_EQ(table.find("GET"), static_cast<std::size_t>(0));
+    EXPECT_EQ(table.find("PATCH"_sr), static_cast<std::size_t>(8));
+    EXPECT_EQ(table.find(std::string("DELETE")), static_cast<std::size_t>(4));
+    EXPECT_EQ(table.find(stringref("OPTIONS")), static_cast<std::size_t>(6));
+    EXPECT_EQ(table.find(cistringref("POST")), static_cast<std::size_t>(2));
+    EXPECT_EQ(table.find("get"), stringref_perfect_table::npos);
+    EXPECT_EQ(table.find("GETS"), stringref_perfect_table::npos);
+    EXPECT_EQ(table.find(""), stringref_perfect_table::npos);
+    EXPECT_EQ(table.find(static_cast<const char*>(nullptr)), stringref_perfect_table::npos);
+    EXPECT_TRUE(table.contains("TRACE"));
+    EXPECT_FALSE(table.contains("BREW"));
+
+    // Keys are parts of one data block.
+    EXPECT_TRUE(table.data().is_detached());
+    EXPECT_EQ(table.data().size(), static_cast<std::size_t>(44));
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        EXPECT_EQ(table.find(table.key(i)), i);
+        EXPECT_NE(table.data().find(table.key(i)), stringref::npos);
+    }
+    EXPECT_EQ(table.key(1), "HEAD");
+
+    stringref_perfect_table empty({});
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.find("GET"), stringref_perfect_table::npos);
+
+    EXPECT_THROW(stringref_perfect_table({"a"_sr, "b"_sr, "a"_sr}), std::invalid_argument);
+    EXPECT_THROW(cistringref_perfect_table({cistringref("Host"), cistringref("HOST")}), std::invalid_argument);
+}
+
+TEST(Common, PerfectTableLarge)
+{
+    using namespace mg;
+    std::vector<std::string> keys;
+    const std::size_t count = 20000;
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back("/api/v" + std::to_string(i % 7) + "/route/" + std::to_string(i * 104729));
+    }
+    stringref_perfect_table table(keys.begin(), keys.end());
+    EXPECT_EQ(table.size(), count);
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(table.find(keys[i]), i);
+        EXPECT_EQ(table.key(i), keys[i].c_str());
+    }
+    // Every slot is taken, so a missing key is rejected by the comparison.
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(table.find(keys[i] + "/"), stringref_perfect_table::npos);
+    }
+
+    cistringref_perfect_table citable({cistringref("Content-Type"), cistringref("Content-Length"), cistringref("Host"),
+                                       cistringref("Accept")});
+    EXPECT_EQ(citable.find("HOST"), static_cast<std::size_t>(2));
+    EXPECT_EQ(citable.find(std::string("content-length")), static_cast<std::size_t>(1));
+
+    wstringref_perfect_table wtable({wstringref(L"alpha"), wstringref(L"beta")});
+    EXPECT_EQ(wtable.find(L"beta"), static_cast<std::size_t>(1));
+}
+
+TEST_F(CustomAllocator, PerfectTable)
+{
+    using namespace inplace;
+    typedef mg::basic_stringref_perfect_table<char, std::char_traits<char>, ::inplace::allocator<char> > table_type;
+    {
+        table_type table({stringref("first key, which is long enough", a), stringref("second key", a)}, a);
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+        EXPECT_EQ(table.find("second key"), static_cast<std::size_t>(1));
+        stringref key(table.key(0));
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+        EXPECT_EQ(key, "first key, which is long enough");
+    }
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+}
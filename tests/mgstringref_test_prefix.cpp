@@ -0,0 +1,125 @@
+#include "mgstringref_test.h"
+
+namespace {
+    // Compares results with std::basic_string for every prefix and suffix length, so that words of every
+    // size and overlapping tails are covered.
+    template<typename _Stringref>
+    void CheckAffixes(const std::basic_string<typename _Stringref::value_type>& str)
+    {
+        typedef std::basic_string<typename _Stringref::value_type> string_type;
+        _Stringref sr(str.data(), str.size());
+        for (std::size_t n = 0; n <= str.size(); ++n) {
+            string_type prefix(str, 0, n);
+            string_type suffix(str, str.size() - n);
+            EXPECT_TRUE(sr.starts_with(prefix));
+            EXPECT_TRUE(sr.ends_with(suffix));
+            EXPECT_TRUE(sr.starts_with(prefix.c_str()));
+            EXPECT_TRUE(sr.ends_with(_Stringref(suffix.data(), suffix.size())));
+            for (std::size_t i = 0; i < n; ++i) {
+                string_type p(prefix);
+                p[i] = static_cast<typename _Stringref::value_type>(p[i] ^ 0x40);
+                EXPECT_FALSE(sr.starts_with(p));
+                string_type s(suffix);
+                s[i] = static_cast<typename _Stringref::value_type>(s[i] ^ 0x40);
+                EXPECT_FALSE(sr.ends_with(s));
+            }
+        }
+        EXPECT_FALSE(sr.starts_with(str + str[0]));
+        EXPECT_FALSE(sr.ends_with(str + str[0]));
+    }
+}
+
+TEST(Common, StartsWith)
+{
+    using namespace mg;
+    using namespace mg::literals;
+    CheckAffixes<stringref>("GET /api/v1/users/12345?fields=name,email HTTP/1.1");
+    CheckAffixes<ustringref>(u"GET /api/v1/users/12345?fields=name HTTP/1.1");
+    CheckAffixes<wstringref>(L"GET /api/v1/users/12345 HTTP/1.1");
+
+    stringref request("GET /index.html HTTP/1.1");
+    EXPECT_TRUE(request.starts_with('G'));
+    EXPECT_FALSE(request.starts_with('g'));
+    EXPECT_TRUE(request.starts_with("GET "_sr));
+    EXPECT_FALSE(request.starts_with("POST "_sr));
+    EXPECT_TRUE(request.starts_with(""));
+    EXPECT_TRUE(request.starts_with(nullptr));
+    EXPECT_TRUE(request.starts_with("GET /index.html HTTP/1.1"));
+    EXPECT_FALSE(stringref().starts_with('G'));
+    EXPECT_TRUE(stringref().starts_with(""_sr));
+
+    cistringref header("Content-Type: text/html");
+    EXPECT_TRUE(header.starts_with("content-type:"));
+    EXPECT_TRUE(header.ends_with("TEXT/HTML"));
+    EXPECT_TRUE(header.starts_with('c'));
+}
+
+TEST(Common, EndsWith)
+{
+    using namespace mg;
+    using namespace mg::literals;
+    stringref request("GET /index.html HTTP/1.1");
+    EXPECT_TRUE(request.ends_with('1'));
+    EXPECT_FALSE(request.ends_with('0'));
+    EXPECT_TRUE(request.ends_with(" HTTP/1.1"_sr));
+    EXPECT_FALSE(request.ends_with(" HTTP/1.0"_sr));
+    EXPECT_TRUE(request.ends_with(std::string("1.1")));
+    EXPECT_TRUE(request.ends_with(""));
+    EXPECT_FALSE(stringref().ends_with('1'));
+    EXPECT_FALSE(stringref("1.1").ends_with("HTTP/1.1"));
+}
+
+TEST_F(CustomAllocator, RemovePrefix)
+{
+    using namespace inplace;
+    stringref s("/api/v1/users/12345", stringref::detached, a);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    stringref path(s);
+    path.remove_prefix(4);
+    EXPECT_EQ(path, "/v1/users/12345");
+    EXPECT_EQ(path.data(), s.data() + 4);
+    path.remove_suffix(6);
+    EXPECT_EQ(path, "/v1/users");
+    EXPECT_EQ(path.data(), s.data() + 4);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+
+    path.remove_prefix(100);
+    EXPECT_TRUE(path.empty());
+    s.remove_suffix(100);
+    EXPECT_TRUE(s.empty());
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+
+    stringref ref("/api/v1/users", a);
+    ref.remove_prefix(4).remove_suffix(6);
+    EXPECT_EQ(ref, "/v1");
+    EXPECT_FALSE(ref.is_detached());
+
+    stringref small("/api/v1", stringref::detached, a);
+    small.remove_prefix(4);
+    EXPECT_EQ(small, "/v1");
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+}
+
+TEST_F(CustomAllocator, StripPrefix)
+{
+    using namespace inplace;
+    using namespace mg::literals;
+    stringref s("Authorization: Bearer 0123456789abcdef", stringref::detached, a);
+    stringref value = s.strip_prefix("Authorization: "_sr);
+    EXPECT_EQ(value, "Bearer 0123456789abcdef");
+    EXPECT_EQ(value.data(), s.data() + 15);
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(1));
+
+    stringref token = value.strip_prefix(std::string("Bearer "));
+    EXPECT_EQ(token, "0123456789abcdef");
+    EXPECT_EQ(token.data(), s.data() + 22);
+    EXPECT_EQ(token.strip_prefix('0'), "123456789abcdef");
+
+    // Without the prefix, the whole string is returned.
+    stringref same = s.strip_prefix("Cookie: ");
+    EXPECT_EQ(same, s);
+    EXPECT_EQ(same.data(), s.data());
+    EXPECT_EQ(s.strip_prefix(s), "");
+    EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+}
@@ -0,0 +1,234 @@
+#include "mgstringref_test.h"
+#include "mgstringref_radix_tree.h"
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace {
+    // Deterministic pseudo-random numbers, so failures are reproducible.
+    std::uint32_t next_random(std::uint32_t& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+}
+
+TEST(Common, RadixTree)
+{
+    using namespace mg;
+    stringref_radix_tree<int> tree;
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.begin(), tree.end());
+    EXPECT_EQ(tree.lower_bound(stringref("a")), tree.end());
+    EXPECT_FALSE(tree.contains(stringref("a")));
+
+    const char* keys[] = {"tenant/42/users", "tenant/42/", "tenant/4", "tenant/42/orders", "tenant/43/users", "t",
+                          "", "tenant/42/users/1", "zeta", "tenant/420/x"};
+    int value = 0;
+    for (const char* key : keys) {
+        EXPECT_TRUE(tree.try_emplace(stringref(key), value++).second);
+    }
+    EXPECT_FALSE(tree.try_emplace(stringref("tenant/42/"), 100).second);
+    EXPECT_EQ(tree.size(), static_cast<std::size_t>(10));
+    EXPECT_EQ(*tree.find_value(stringref("tenant/42/")), 1);
+    EXPECT_EQ(*tree.find_value(stringref("")), 6);
+    EXPECT_EQ(tree.find_value(stringref("tenant/42")), nullptr);
+    EXPECT_EQ(tree.find_value(stringref("tenant/42/users/")), nullptr);
+    EXPECT_EQ(tree.find_value(stringref("tenant/44/users")), nullptr);
+    EXPECT_EQ(tree.find(stringref("tenant/43/users"))->second, 4);
+    EXPECT_EQ(tree.find(stringref("zet")), tree.end());
+    tree[stringref("t")] = 50;
+    EXPECT_EQ(tree.count(stringref("t")), static_cast<std::size_t>(1));
+    EXPECT_EQ(tree.find(stringref("t"))->second, 50);
+
+    std::vector<std::string> ordered;
+    for (const stringref_radix_tree<int>::value_type& v : tree) {
+        ordered.push_back(std::string(v.first.data(), v.first.size()));
+    }
+    const std::vector<std::string> expected = {"", "t", "tenant/4", "tenant/42/", "tenant/42/orders",
+        "tenant/42/users", "tenant/42/users/1", "tenant/420/x", "tenant/43/users", "zeta"};
+    EXPECT_EQ(ordered, expected);
+
+    EXPECT_EQ(tree.lower_bound(stringref("tenant/42"))->first, "tenant/42/");
+    EXPECT_EQ(tree.lower_bound(stringref("tenant/42/p"))->first, "tenant/42/users");
+    EXPECT_EQ(tree.lower_bound(stringref("tenant/42/users"))->first, "tenant/42/users");
+    EXPECT_EQ(tree.lower_bound(stringref("tenant/42/users/2"))->first, "tenant/420/x");
+    EXPECT_EQ(tree.lower_bound(stringref("tenant/5"))->first, "zeta");
+    EXPECT_EQ(tree.lower_bound(stringref("u"))->first, "zeta");
+    EXPECT_EQ(tree.lower_bound(stringref("zz")), tree.end());
+    EXPECT_EQ(tree.lower_bound(stringref(""))->first, "");
+
+    std::vector<std::string> scanned;
+    EXPECT_TRUE(tree.scan_prefix(stringref("tenant/42/"), [&scanned](const stringref_radix_tree<int>::value_type& v) {
+        scanned.push_back(std::string(v.first.data(), v.first.size()));
+        return true;
+    }));
+    EXPECT_EQ(scanned, std::vector<std::string>(expected.begin() + 3, expected.begin() + 7));
+    int count = 0;
+    EXPECT_FALSE(tree.scan_prefix(stringref("tenant/"), [&count](const stringref_radix_tree<int>::value_type&) {
+        return (++count < 2);
+    }));
+    EXPECT_EQ(count, 2);
+    EXPECT_TRUE(tree.scan_prefix(stringref("x"), [](const stringref_radix_tree<int>::value_type&) { return false; }));
+
+    stringref_radix_tree<int> moved(std::move(tree));
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(moved.size(), static_cast<std::size_t>(10));
+    moved.clear();
+    EXPECT_EQ(moved.begin(), moved.end());
+}
+
+TEST(Common, RadixTreeSharing)
+{
+    using namespace mg;
+    stringref_radix_tree<int> tree;
+    stringref shared("a key, which is longer than the inline buffer");
+    shared.detach();
+    tree[shared] = 1;
+    EXPECT_EQ(tree.begin()->first.data(), shared.data());
+
+    std::string temporary("another key, which is longer than the inline buffer");
+    tree[stringref(temporary.data(), temporary.size())] = 2;
+    temporary[0] = 'A';
+    EXPECT_EQ(tree.lower_bound(stringref("another"))->first, "another key, which is longer than the inline buffer");
+    EXPECT_TRUE(tree.lower_bound(stringref("another"))->first.is_detached());
+}
+
+TEST(Common, RadixTreeRandom)
+{
+    using namespace mg;
+    stringref_radix_tree<std::size_t> tree;
+    std::map<std::string, std::size_t> expected;
+    std::uint32_t state = 42;
+    // Keys with long common prefixes and wide fan-out, so all node sizes are used.
+    for (std::size_t i = 0; i < 20000; ++i) {
+        std::string key = "tenant/" + std::to_string(next_random(state) % 300) + "/";
+        const std::size_t parts = next_random(state) % 3;
+        for (std::size_t p = 0; p < parts; ++p) {
+            key += static_cast<char>(next_random(state) % 256);
+            key += "obj/" + std::to_string(next_random(state) % 50);
+        }
+        const bool inserted = expected.insert(std::make_pair(key, i)).second;
+        EXPECT_EQ(tree.try_emplace(stringref(key.data(), key.size()), i).second, inserted);
+    }
+    ASSERT_EQ(tree.size(), expected.size());
+
+    std::map<std::string, std::size_t>::const_iterator e = expected.begin();
+    for (const stringref_radix_tree<std::size_t>::value_type& v : tree) {
+        ASSERT_EQ(std::string(v.first.data(), v.first.size()), e->first);
+        ASSERT_EQ(v.second, e->second);
+        ++e;
+    }
+    for (const std::pair<const std::string, std::size_t>& v : expected) {
+        ASSERT_EQ(*tree.find_value(stringref(v.first.data(), v.first.size())), v.second);
+    }
+
+    // Iterators of find() and try_emplace() continue in order.
+    std::size_t step = 0;
+    for (e = expected.begin(); expected.end() != e; ++e) {
+        if (0 != (++step % 97)) {
+            continue;
+        }
+        stringref key(e->first.data(), e->first.size());
+        stringref_radix_tree<std::size_t>::iterator it = tree.find(key);
+        ASSERT_EQ(it, tree.try_emplace(key, 0).first);
+        ASSERT_EQ(it->second, e->second);
+        std::map<std::string, std::size_t>::const_iterator next = std::next(e);
+        ++it;
+        if (expected.end() == next) {
+            ASSERT_EQ(it, tree.end());
+        } else {
+            ASSERT_EQ(std::string(it->first.data(), it->first.size()), next->first);
+        }
+    }
+
+    for (std::size_t i = 0; i < 5000; ++i) {
+        std::string probe = "tenant/" + std::to_string(next_random(state) % 310);
+        if (0 != next_random(state) % 4) {
+            probe += "/";
+            probe += static_cast<char>(next_random(state) % 256);
+        }
+        stringref probe_ref(probe.data(), probe.size());
+        std::map<std::string, std::size_t>::const_iterator lb = expected.lower_bound(probe);
+        stringref_radix_tree<std::size_t>::const_iterator it =
+            static_cast<const stringref_radix_tree<std::size_t>&>(tree).lower_bound(probe_ref);
+        if (expected.end() == lb) {
+            ASSERT_EQ(it, tree.end());
+        } else {
+            ASSERT_EQ(std::string(it->first.data(), it->first.size()), lb->first);
+        }
+        std::size_t count = 0;
+        tree.scan_prefix(probe_ref, [&count](const stringref_radix_tree<std::size_t>::value_type&) {
+            return ++count;
+        });
+        std::size_t expected_count = 0;
+        for (; (expected.end() != lb) && (0 == lb->first.compare(0, probe.size(), probe)); ++lb) {
+            ++expected_count;
+        }
+        ASSERT_EQ(count, expected_count);
+    }
+}
+
+TEST(Common, RadixTreeDeep)
+{
+    using namespace mg;
+    // Every key is a prefix of the next one, so each key ends at its own node and nodes are nested as deep as the
+    // longest key.
+    stringref text(std::string(5000, 'a').c_str(), stringref::detached);
+    stringref_radix_tree<std::size_t> tree;
+    for (std::size_t i = 1; i <= text.size(); ++i) {
+        tree[stringref(text, 0, i)] = i;
+    }
+    EXPECT_EQ(tree.size(), text.size());
+    std::size_t expected = 0;
+    for (const stringref_radix_tree<std::size_t>::value_type& v : tree) {
+        EXPECT_EQ(v.second, ++expected);
+        EXPECT_EQ(v.first.size(), expected);
+    }
+    EXPECT_EQ(expected, text.size());
+    EXPECT_EQ(tree.lower_bound(stringref("ab")), tree.end());
+    EXPECT_EQ(tree.lower_bound(stringref(text, 0, 100))->second, static_cast<std::size_t>(100));
+    tree.clear();
+    EXPECT_TRUE(tree.empty());
+}
+
+TEST(Common, RadixTreeWide)
+{
+    using namespace mg;
+    ustringref_radix_tree<int> tree;
+    std::map<std::u16string, int> expected;
+    const std::u16string keys[] = {u"ÿ", u"Ā", u"a", u"Ѐb", u"Ѐ", u"￿", u"\u0001Ѐ"};
+    int value = 0;
+    for (const std::u16string& key : keys) {
+        tree[ustringref(key.data(), key.size())] = value;
+        expected[key] = value++;
+    }
+    std::map<std::u16string, int>::const_iterator e = expected.begin();
+    for (const ustringref_radix_tree<int>::value_type& v : tree) {
+        EXPECT_TRUE(v.first == e->first);
+        EXPECT_EQ(v.second, e->second);
+        ++e;
+    }
+    EXPECT_EQ(tree.lower_bound(ustringref(u"ā"))->second, 4);
+}
+
+TEST_F(CustomAllocator, RadixTree)
+{
+    using namespace inplace;
+    {
+        mg::basic_stringref_radix_tree<int, char, ::inplace::allocator<char> > tree(a);
+        stringref key("a key, which is longer than the inline buffer", a);
+        key.detach();
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(1));
+        tree[key] = 1;
+        tree[stringref("a short key", a)] = 2;
+        // Two leaves and the node, the keys are not copied.
+        EXPECT_EQ(a.alloc_count(), static_cast<std::size_t>(4));
+        EXPECT_EQ(tree.begin()->first.data(), key.data());
+        EXPECT_EQ(tree.begin()->second, 1);
+        EXPECT_EQ(*tree.find_value(stringref("a short key", a)), 2);
+    }
+    EXPECT_EQ(a.used_block_count(), static_cast<std::size_t>(0));
+}
@@ -0,0 +1,146 @@
+#include "mgstringref_test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+    typedef mg::basic_stringref<char, std::char_traits<char>, std::allocator<char>,
+                                mg::thread_checked_refcount> tc_stringref;
+
+    const char long_str[] = "Test string, which is too long to be stored inline";
+
+    std::atomic<std::size_t> counting_alloc_count(0);
+    std::atomic<std::size_t> counting_dealloc_count(0);
+
+    template <typename T>
+    class counting_allocator : public std::allocator<T>
+    {
+    public:
+        template <typename U>
+        struct rebind
+        { typedef counting_allocator<U> other; };
+
+        counting_allocator() = default;
+
+        template <typename U>
+        counting_allocator(const counting_allocator<U>&) noexcept
+        {}
+
+        T* allocate(std::size_t n)
+        {
+            ++counting_alloc_count;
+            return std::allocator<T>::allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n)
+        {
+            ++counting_dealloc_count;
+            std::allocator<T>::deallocate(p, n);
+        }
+    };
+}
+
+TEST(Common, SingleThreadRefCount)
+{
+    using namespace mg;
+
+    st_stringref s1(long_str, st_stringref::detached);
+    st_ustringref us1(u"Test string, which is too long to be stored inline", st_ustringref::detached);
+    st_wstringref ws1(L"Test string, which is too long to be stored inline", st_wstringref::detached);
+    EXPECT_TRUE(s1.is_detached());
+    EXPECT_TRUE(us1.is_detached());
+    EXPECT_TRUE(ws1.is_detached());
+    EXPECT_NE(s1.data(), long_str);
+
+    st_stringref s2(s1);
+    st_stringref s3(s1, 5, 6);
+    st_ustringref us2(us1, 5, 6);
+    st_wstringref ws2(ws1, 5, 6);
+    EXPECT_EQ(s2.data(), s1.data());
+    EXPECT_EQ(s3.data(), s1.data() + 5);
+    EXPECT_EQ(us2.data(), us1.data() + 5);
+    EXPECT_EQ(ws2.data(), ws1.data() + 5);
+    EXPECT_EQ(s3, "string");
+    EXPECT_EQ(us2, u"string");
+    EXPECT_EQ(ws2, L"string");
+
+    s1.assign("Other string, which is too long to be stored inline", st_stringref::detached);
+    EXPECT_EQ(s1, "Other string, which is too long to be stored inline");
+    EXPECT_EQ(s2, long_str);
+    EXPECT_EQ(s3, "string");
+}
+
+TEST(Common, ThreadCheckedRefCount)
+{
+    tc_stringref s1(long_str, tc_stringref::detached);
+    tc_stringref s2(s1);
+    tc_stringref s3(s1, 5, 6);
+    EXPECT_EQ(s2.data(), s1.data());
+    EXPECT_EQ(s3, "string");
+    s3.assign(s2);
+    EXPECT_EQ(s3.data(), s1.data());
+}
+
+TEST(Common, RefCountConversion)
+{
+    using namespace mg;
+
+    stringref s1(long_str, stringref::detached);
+    st_stringref s2(s1);
+    EXPECT_TRUE(s2.is_detached());
+    EXPECT_NE(s2.data(), s1.data());
+    EXPECT_EQ(s2, s1);
+
+    stringref s3(long_str);
+    st_stringref s4(s3);
+    EXPECT_FALSE(s4.is_detached());
+    EXPECT_EQ(s4.data(), s3.data());
+
+    stringref s5;
+    s5.assign(s2);
+    EXPECT_TRUE(s5.is_detached());
+    EXPECT_NE(s5.data(), s2.data());
+    EXPECT_EQ(s5, long_str);
+}
+
+TEST(Common, AtomicRefCountStress)
+{
+    typedef mg::basic_stringref<char, std::char_traits<char>, counting_allocator<char> > stringref;
+    counting_alloc_count = 0;
+    counting_dealloc_count = 0;
+
+    {
+        stringref source(long_str, stringref::detached);
+        std::atomic<bool> ok(true);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; t++) {
+            threads.emplace_back([&source, &ok]() {
+                std::vector<stringref> copies(16);
+                for (int i = 0; i < 20000; i++) {
+                    stringref& copy = copies[i % copies.size()];
+                    copy.assign(source, i % 10, 20);
+                    stringref moved(std::move(copy));
+                    if ((moved.data() != source.data() + (i % 10)) || (moved.size() != 20)) {
+                        ok = false;
+                    }
+                    copy.assign(moved);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_TRUE(ok);
+        EXPECT_EQ(source, long_str);
+        EXPECT_EQ(counting_alloc_count.load(), static_cast<std::size_t>(1));
+        EXPECT_EQ(counting_dealloc_count.load(), static_cast<std::size_t>(0));
+
+        // All copies are released, so the data block may be reused.
+        const char* data = source.data();
+        source.assign("Test string, which is too long to be stored INLINE", stringref::detached);
+        EXPECT_EQ(source.data(), data);
+    }
+    EXPECT_EQ(counting_alloc_count.load(), static_cast<std::size_t>(1));
+    EXPECT_EQ(counting_dealloc_count.load(), static_cast<std::size_t>(1));
+}